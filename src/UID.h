@@ -39,11 +39,13 @@
 
 struct TagEntry
 {
-    byte uid[7];  // UID of the tag
-    int category; // Category of the tag
+    byte uid[7];   // UID of the tag
+    byte category; // Category of the tag
 };
 
-const TagEntry registered[] = {
+// Source list only, the firmware looks tags up in the packed copy built by
+// registry.h
+constexpr TagEntry registered[] = {
     {{0x04, 0x4B, 0x51, 0x5A, 0xC1, 0x2A, 0x81}, LINE_STRAIGHT},
     {{0x04, 0x8F, 0x2B, 0x5A, 0xC1, 0x2A, 0x81}, LINE_STRAIGHT},
     {{0x04, 0x81, 0x37, 0x5A, 0xC1, 0x2A, 0x81}, LINE_STRAIGHT},
@@ -122,6 +124,6 @@ const TagEntry registered[] = {
     {{0x04, 0x54, 0x38, 0x2A, 0xBB, 0x2A, 0x81}, ADMIN_KEY_J}};
 
 // The number of registered tags
-const int registeredCount = sizeof(registered) / sizeof(TagEntry);
+constexpr int registeredCount = sizeof(registered) / sizeof(TagEntry);
 
 #endif
\ No newline at end of file
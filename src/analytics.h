@@ -0,0 +1,319 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <stddef.h>
+#include <string.h>
+#include <hardware/flash.h>
+#include <hardware/sync.h>
+#include "packstore.h"
+#include "recovery.h"
+#include "rules.h"
+#include "telemetry.h"
+
+// Session analytics: every evaluated button press is recorded in a RAM ring
+// (a 32-byte copy, no allocation) and written to a circular log in the
+// filesystem area of the flash (board_build.filesystem_size) in whole pages,
+// after the level pack sector (packstore.h).
+// Flash work only runs from loop() while no table is between a press and its
+// verdict, one erase or one batch per pass, so erase stalls never land on the
+// button path. EXPORT sends the log and the records still in RAM in one
+// binary transfer, oldest first; tools/session_export decodes it.
+
+struct SessionRecord
+{
+  uint32_t sequence; // Press number since the log was erased, 0xFFFFFFFF marks a blank slot
+  uint32_t timeMs;   // millis() at the button press
+  uint16_t boot;     // Boot number, starts a new session clock
+  byte table;
+  byte level;
+  byte branch;
+  byte track;
+  byte nextLevel;
+  byte reserved;
+  uint64_t board;           // boardState: category histogram and occupied gates
+  byte cards[numGatePins];  // presentCards
+  uint16_t check;           // CRC-16 of the bytes before, set when the record is written to flash
+};
+
+static_assert(sizeof(SessionRecord) == 32, "Records must tile a flash page");
+
+const int recordsPerPage = FLASH_PAGE_SIZE / sizeof(SessionRecord);
+const int recordsPerSector = FLASH_SECTOR_SIZE / sizeof(SessionRecord);
+const int sessionRingSize = 256;                 // Records kept in RAM, power of two
+const int flushBatch = 8 * recordsPerPage;       // Records written in one go
+const unsigned long flushIdleMs = 300000;        // Also flush smaller batches after this quiet time
+const uint32_t eraseWatchdogTimeout = 1000;      // A sector erase can take up to 400 ms
+const unsigned long exportStallMs = 2000;        // Give up an export the host stopped reading
+
+SessionRecord sessionRing[sessionRingSize];
+uint32_t sessionHead = 0;    // Records ever recorded since boot
+uint32_t sessionFlushed = 0; // Records ever written to flash since boot
+uint32_t nextSequence = 0;
+uint16_t sessionBoot = 0;
+uint32_t logSlots = 0;       // Records the flash log holds
+uint32_t logNext = 0;        // Slot the next record goes to
+bool logSectorErased = false; // The sector of logNext is blank from logNext on
+unsigned long lastSessionRecord = 0;
+
+// Counters for STATS
+unsigned long sessionsDropped = 0; // Overwritten in RAM before they were flushed
+unsigned long flashPrograms = 0;
+unsigned long flashErases = 0;
+unsigned long longestFlashUs = 0;
+
+uint16_t recordCheck(const SessionRecord &r)
+{
+  uint16_t crc = 0xFFFF;
+  const byte *bytes = (const byte *)&r;
+  for (size_t i = 0; i < offsetof(SessionRecord, check); i++)
+  {
+    crc = crc16(crc, bytes[i]);
+  }
+  return crc;
+}
+
+const SessionRecord *logSlot(uint32_t slot)
+{
+  return (const SessionRecord *)(&_FS_start + packAreaSize) + slot;
+}
+
+uint32_t logOffset(uint32_t slot)
+{
+  return packOffset() + packAreaSize + slot * sizeof(SessionRecord);
+}
+
+bool slotsBlank(uint32_t from, uint32_t to)
+{
+  const uint32_t *words = (const uint32_t *)logSlot(from);
+  for (uint32_t i = 0; i < (to - from) * sizeof(SessionRecord) / 4; i++)
+  {
+    if (words[i] != 0xFFFFFFFF)
+      return false;
+  }
+  return true;
+}
+
+// Written by flushAnalytics(), anything else in the area is not a record
+bool validSlot(uint32_t slot)
+{
+  const SessionRecord *r = logSlot(slot);
+  return r->sequence != 0xFFFFFFFF && r->check == recordCheck(*r);
+}
+
+// Find the newest record in the log, the next press goes after it
+void initAnalytics()
+{
+  logSlots = (&_FS_end - &_FS_start - packAreaSize) / sizeof(SessionRecord);
+  logSlots -= logSlots % recordsPerSector;
+  if (logSlots == 0)
+    return;
+
+  int32_t newest = -1;
+  for (uint32_t slot = 0; slot < logSlots; slot++)
+  {
+    if (!validSlot(slot))
+      continue;
+    if (newest < 0 || logSlot(slot)->sequence > logSlot(newest)->sequence)
+      newest = slot;
+  }
+
+  if (newest >= 0)
+  {
+    nextSequence = logSlot(newest)->sequence + 1;
+    sessionBoot = logSlot(newest)->boot + 1;
+    // Continue on the next page, a partly written page is never programmed again
+    logNext = (newest / recordsPerPage + 1) * recordsPerPage % logSlots;
+  }
+
+  uint32_t sectorEnd = (logNext / recordsPerSector + 1) * recordsPerSector;
+  logSectorErased = slotsBlank(logNext, sectorEnd);
+}
+
+// Copy one press into the RAM ring, the oldest unflushed record is lost when
+// the ring is full
+void recordSession(byte table, byte level, const Outcome &outcome, unsigned long timeMs)
+{
+  if (sessionHead - sessionFlushed >= (uint32_t)sessionRingSize)
+  {
+    sessionsDropped++;
+    sessionFlushed++;
+  }
+
+  SessionRecord &r = sessionRing[sessionHead % sessionRingSize];
+  r.sequence = nextSequence++;
+  r.timeMs = timeMs;
+  r.boot = sessionBoot;
+  r.table = table;
+  r.level = level;
+  r.branch = outcome.branch;
+  r.track = outcome.track;
+  r.nextLevel = outcome.nextLevel;
+  r.reserved = 0xFF;
+  r.board = boardState;
+  memcpy(r.cards, presentCards, sizeof(r.cards));
+  sessionHead++;
+  lastSessionRecord = millis();
+}
+
+uint32_t sessionsPending()
+{
+  return sessionHead - sessionFlushed;
+}
+
+void noteFlashTime(unsigned long start)
+{
+  unsigned long elapsed = micros() - start;
+  if (elapsed > longestFlashUs)
+    longestFlashUs = elapsed;
+}
+
+// One piece of flash work: erase the sector the log continues in, or write
+// the pending whole pages up to the end of that sector. Only call while no
+// button press is waiting for its verdict; returns true when it did anything.
+bool flushAnalytics()
+{
+  if (logSlots == 0)
+    return false;
+
+  uint32_t pages = sessionsPending() / recordsPerPage;
+  bool quiet = millis() - lastSessionRecord >= flushIdleMs;
+  if (pages == 0 || (sessionsPending() < (uint32_t)flushBatch && !quiet))
+    return false;
+
+  unsigned long start = micros();
+
+  if (!logSectorErased)
+  {
+    watchdog_enable(eraseWatchdogTimeout, true);
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_erase(logOffset(logNext - logNext % recordsPerSector), FLASH_SECTOR_SIZE);
+    restore_interrupts(ints);
+    armWatchdog();
+    flashErases++;
+    logSectorErased = true;
+    noteFlashTime(start);
+    return true;
+  }
+
+  uint32_t sectorLeft = (recordsPerSector - logNext % recordsPerSector) / recordsPerPage;
+  if (pages > sectorLeft)
+    pages = sectorLeft;
+
+  // The ring may wrap inside the batch, copy the records in order first
+  static SessionRecord batch[flushBatch];
+  if (pages > (uint32_t)flushBatch / recordsPerPage)
+    pages = flushBatch / recordsPerPage;
+  uint32_t count = pages * recordsPerPage;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    batch[i] = sessionRing[(sessionFlushed + i) % sessionRingSize];
+    batch[i].check = recordCheck(batch[i]);
+  }
+
+  uint32_t ints = save_and_disable_interrupts();
+  flash_range_program(logOffset(logNext), (const uint8_t *)batch, count * sizeof(SessionRecord));
+  restore_interrupts(ints);
+  flashPrograms++;
+  noteFlashTime(start);
+
+  sessionFlushed += count;
+  logNext = (logNext + count) % logSlots;
+  if (logNext % recordsPerSector == 0)
+    logSectorErased = false;
+  return true;
+}
+
+// Write only what the port takes without blocking and feed the watchdog in
+// between, false when the host stopped reading
+bool exportBytes(Print &out, const byte *bytes, size_t size)
+{
+  unsigned long progress = millis();
+  while (size > 0)
+  {
+    feedWatchdog();
+    int room = out.availableForWrite();
+    if (room <= 0)
+    {
+      if (millis() - progress >= exportStallMs)
+        return false;
+      continue;
+    }
+    size_t written = out.write(bytes, (size_t)room < size ? room : size);
+    bytes += written;
+    size -= written;
+    if (written > 0)
+      progress = millis();
+  }
+  return true;
+}
+
+bool writeExport(Print &out, const void *data, size_t size, uint16_t &crc)
+{
+  const byte *bytes = (const byte *)data;
+  for (size_t i = 0; i < size; i++)
+  {
+    crc = crc16(crc, bytes[i]);
+  }
+  return exportBytes(out, bytes, size);
+}
+
+// Send every record, oldest first: "NVSL", u16 record size, u32 count, the
+// records, CRC-16 over count and records. Returns false when the host
+// stopped reading and the export was cut short.
+bool exportSessions(Print &out)
+{
+  uint32_t count = 0;
+  for (uint32_t slot = 0; slot < logSlots; slot++)
+  {
+    if (validSlot(slot))
+      count++;
+  }
+  count += sessionsPending();
+
+  uint16_t crc = 0xFFFF;
+  uint16_t recordSize = sizeof(SessionRecord);
+  if (!exportBytes(out, (const byte *)"NVSL", 4) ||
+      !exportBytes(out, (const byte *)&recordSize, sizeof(recordSize)) ||
+      !writeExport(out, &count, sizeof(count), crc))
+    return false;
+
+  // The oldest flash record follows the newest one, the log is circular
+  for (uint32_t i = 0; i < logSlots; i++)
+  {
+    uint32_t slot = (logNext + i) % logSlots;
+    if (validSlot(slot) && !writeExport(out, logSlot(slot), sizeof(SessionRecord), crc))
+      return false;
+    feedWatchdog();
+  }
+  for (uint32_t i = sessionFlushed; i != sessionHead; i++)
+  {
+    SessionRecord &r = sessionRing[i % sessionRingSize];
+    r.check = recordCheck(r);
+    if (!writeExport(out, &r, sizeof(SessionRecord), crc))
+      return false;
+  }
+  return exportBytes(out, (const byte *)&crc, sizeof(crc));
+}
+
+void printAnalyticsStats()
+{
+  Serial.print("Analytics: recorded ");
+  Serial.print(sessionHead);
+  Serial.print(", in RAM ");
+  Serial.print(sessionsPending());
+  Serial.print(", dropped ");
+  Serial.print(sessionsDropped);
+  Serial.print(", log slot ");
+  Serial.print(logNext);
+  Serial.print(" of ");
+  Serial.print(logSlots);
+  Serial.print(", programs ");
+  Serial.print(flashPrograms);
+  Serial.print(", erases ");
+  Serial.print(flashErases);
+  Serial.print(", longest flash stall ");
+  Serial.print(longestFlashUs);
+  Serial.println(" us");
+}
+
+#endif
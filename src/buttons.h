@@ -0,0 +1,156 @@
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <pico/time.h>
+#include <hardware/sync.h>
+#include "gates.h"
+
+// Buttons, one per table, are captured by edge interrupts instead of being
+// sampled from loop(). The GPIO interrupt stamps the first edge of a bounce
+// burst and arms an alarm, which accepts the new level once the pin has been
+// quiet for buttonSettleUs and queues it with the time of that first edge.
+// Nothing runs while no button moves, so an idle core stays asleep. Both run
+// at the default interrupt priority, so they never preempt each other, and
+// loop() is the only reader of the queue. A press during a scan or a blocking
+// wait is therefore neither lost nor stamped late.
+
+const uint32_t buttonSettleUs = 25000; // Quiet time before a level counts
+const int buttonQueueSize = 16;        // Power of two, at most 256
+
+struct ButtonEvent
+{
+  byte button;      // Table of the button
+  bool pressed;     // false for a release
+  uint32_t timeUs;  // micros() at the first edge
+};
+
+struct ButtonState
+{
+  int pin;
+  volatile bool pressed;  // Accepted level
+  volatile bool bouncing; // Edges seen since the level was last accepted
+  volatile uint32_t firstEdgeUs;
+  volatile uint32_t lastEdgeUs;
+};
+
+ButtonState buttons[numTables];
+ButtonEvent buttonQueue[buttonQueueSize];
+volatile byte buttonHead = 0; // Written by the interrupts only
+volatile byte buttonTail = 0; // Written by loop() only
+alarm_id_t buttonAlarm = 0; // Pending settle check, 0 when none
+
+// Counters for STATS
+volatile unsigned long buttonEdges = 0;
+volatile unsigned long buttonOverflows = 0;
+unsigned long maxButtonWaitUs = 0; // Longest time from a press to loop() taking it
+
+// Interrupt side of the queue, an event that does not fit is dropped
+void pushButtonEvent(byte button, bool pressed, uint32_t timeUs)
+{
+  byte head = buttonHead;
+  if ((byte)(head - buttonTail) >= buttonQueueSize)
+  {
+    buttonOverflows++;
+    return;
+  }
+  buttonQueue[head & (buttonQueueSize - 1)] = {button, pressed, timeUs};
+  __compiler_memory_barrier(); // Event before the index that publishes it
+  buttonHead = head + 1;
+}
+
+// Alarm: accept the level of every button that has gone quiet, returns the
+// time until the next one does, 0 when none is bouncing
+int64_t settleButtons(alarm_id_t id, void *data)
+{
+  uint32_t now = micros();
+  uint32_t next = 0;
+  for (int b = 0; b < numTables; b++)
+  {
+    ButtonState &s = buttons[b];
+    if (!s.bouncing)
+      continue;
+
+    uint32_t quiet = now - s.lastEdgeUs;
+    if (quiet < buttonSettleUs)
+    {
+      if (next == 0 || buttonSettleUs - quiet < next)
+        next = buttonSettleUs - quiet;
+      continue;
+    }
+
+    s.bouncing = false;
+    bool pressed = digitalRead(s.pin) == LOW;
+    if (pressed != s.pressed)
+    {
+      s.pressed = pressed;
+      pushButtonEvent(b, pressed, s.firstEdgeUs);
+    }
+  }
+  if (next == 0)
+    buttonAlarm = 0;
+  return -(int64_t)next; // Negative counts from now, 0 stops the alarm
+}
+
+// GPIO interrupt, param is the button index
+void buttonEdge(void *param)
+{
+  ButtonState &s = buttons[(intptr_t)param];
+  uint32_t now = micros();
+  if (!s.bouncing)
+  {
+    s.firstEdgeUs = now;
+    s.bouncing = true;
+  }
+  s.lastEdgeUs = now;
+  buttonEdges++;
+
+  if (buttonAlarm == 0)
+  {
+    alarm_id_t id = add_alarm_in_us(buttonSettleUs, settleButtons, nullptr, true);
+    buttonAlarm = id > 0 ? id : 0;
+  }
+}
+
+// Button of table b, pulled up and pressed when low
+void initButton(int b, int pin)
+{
+  ButtonState &s = buttons[b];
+  pinMode(pin, INPUT_PULLUP);
+  s.pin = pin;
+  s.pressed = digitalRead(pin) == LOW;
+  s.bouncing = false;
+  attachInterruptParam(digitalPinToInterrupt(pin), buttonEdge, CHANGE, (void *)(intptr_t)b);
+}
+
+// Take the oldest event, false when the queue is empty
+bool nextButtonEvent(ButtonEvent &event)
+{
+  byte tail = buttonTail;
+  if (tail == buttonHead)
+    return false;
+  __compiler_memory_barrier();
+  event = buttonQueue[tail & (buttonQueueSize - 1)];
+  __compiler_memory_barrier(); // Copy out before the slot is given back
+  buttonTail = tail + 1;
+
+  if (event.pressed)
+  {
+    unsigned long waited = micros() - event.timeUs;
+    if (waited > maxButtonWaitUs)
+      maxButtonWaitUs = waited;
+  }
+  return true;
+}
+
+void printButtonStats()
+{
+  Serial.print("Buttons: ");
+  Serial.print(buttonEdges);
+  Serial.print(" edges, ");
+  Serial.print(buttonOverflows);
+  Serial.print(" queue overflows, longest wait for loop() ");
+  Serial.print(maxButtonWaitUs);
+  Serial.println(" us");
+}
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <string.h>
+#include <strings.h>
+
+// Line-based operator console on the USB serial port. Characters are
+// collected without blocking from loop(), a complete line runs the command
+// named by its first word. Words are matched case-insensitively. A command
+// can take a binary block after its line with receiveConsoleBytes().
+
+struct ConsoleCommand
+{
+  const char *name;        // First word of the line
+  void (*run)(char *args); // Handler, gets the rest of the line
+  const char *help;        // Arguments and description for HELP
+};
+
+char consoleLine[64]; // Line being received
+int consoleLength = 0;
+bool consoleOverflow = false; // Line longer than consoleLine, dropped
+char consoleLineEnd = '\n';   // Character that ended the last line
+
+const unsigned long consoleBytesTimeout = 2000; // Give up on a block after this quiet time
+
+byte *consoleBytes = nullptr; // Block being received, nullptr for lines
+uint32_t consoleBytesLeft = 0;
+unsigned long consoleBytesLast = 0;
+bool consoleBytesSkipLf = false; // The line ended in CR, a LF may follow it
+void (*consoleBytesDone)(bool complete);
+
+// Put the next size bytes into buffer instead of reading lines, done runs
+// when they are in or the sender went quiet
+void receiveConsoleBytes(byte *buffer, uint32_t size, void (*done)(bool complete))
+{
+  consoleBytes = buffer;
+  consoleBytesLeft = size;
+  consoleBytesLast = millis();
+  consoleBytesSkipLf = consoleLineEnd == '\r';
+  consoleBytesDone = done;
+}
+
+// Receive part of a block, returns false while lines are being read
+bool pollConsoleBytes()
+{
+  if (consoleBytes == nullptr)
+    return false;
+
+  while (consoleBytesLeft > 0 && Serial.available() > 0)
+  {
+    byte b = Serial.read();
+    if (consoleBytesSkipLf)
+    {
+      consoleBytesSkipLf = false;
+      if (b == '\n')
+        continue;
+    }
+    *consoleBytes++ = b;
+    consoleBytesLeft--;
+    consoleBytesLast = millis();
+  }
+
+  bool complete = consoleBytesLeft == 0;
+  if (complete || millis() - consoleBytesLast >= consoleBytesTimeout)
+  {
+    consoleBytes = nullptr;
+    consoleBytesDone(complete);
+  }
+  return true;
+}
+
+void printConsoleHelp(const ConsoleCommand *commands, int count)
+{
+  Serial.println("Commands:");
+  for (int i = 0; i < count; i++)
+  {
+    Serial.print("  ");
+    Serial.print(commands[i].name);
+    Serial.print(" ");
+    Serial.println(commands[i].help);
+  }
+}
+
+void runConsoleLine(char *line, const ConsoleCommand *commands, int count)
+{
+  while (*line == ' ')
+    line++;
+
+  char *args = line;
+  while (*args != '\0' && *args != ' ')
+    args++;
+  if (*args != '\0')
+    *args++ = '\0';
+
+  if (strcasecmp(line, "HELP") == 0)
+  {
+    printConsoleHelp(commands, count);
+    return;
+  }
+
+  for (int i = 0; i < count; i++)
+  {
+    if (strcasecmp(line, commands[i].name) == 0)
+    {
+      commands[i].run(args);
+      return;
+    }
+  }
+
+  Serial.print("Unknown command: ");
+  Serial.print(line);
+  Serial.println(", type HELP for a list.");
+}
+
+// Collect the characters received so far and run complete lines
+void pollConsole(const ConsoleCommand *commands, int count)
+{
+  while (!pollConsoleBytes() && Serial.available() > 0)
+  {
+    char c = Serial.read();
+    if (c == '\r' || c == '\n')
+    {
+      if (consoleOverflow)
+      {
+        Serial.println("Command too long, ignored.");
+      }
+      else if (consoleLength > 0)
+      {
+        consoleLineEnd = c;
+        consoleLine[consoleLength] = '\0';
+        runConsoleLine(consoleLine, commands, count);
+      }
+      consoleLength = 0;
+      consoleOverflow = false;
+    }
+    else if (consoleLength < (int)sizeof(consoleLine) - 1)
+    {
+      consoleLine[consoleLength++] = c;
+    }
+    else
+    {
+      consoleOverflow = true;
+    }
+  }
+}
+
+#endif
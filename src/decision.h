@@ -0,0 +1,112 @@
+#ifndef DECISION_H
+#define DECISION_H
+
+#include "rules.h"
+#include "decision_table.h"
+
+bool decisionTableValid = false; // Set once the table agrees with the rules
+
+// Outcome from the generated decision table, same result as evaluateBoard()
+Outcome lookupOutcome(int level)
+{
+  if (((validOccupancy >> occupancyMask()) & 1) == 0)
+  {
+    return outcomeFromBranch(level, BRANCH_MASK);
+  }
+
+  if (level < 0 || level >= numLevels)
+  {
+    return outcomeFromBranch(level, BRANCH_INVALID_LEVEL);
+  }
+
+  // The table only knows the counted categories
+  if (!boardCounted())
+  {
+    return evaluateBoard(level);
+  }
+
+  int rank = boardRank();
+  byte packed = decisionTable[level][rank / 2];
+  return outcomeFromBranch(level, (rank & 1) ? packed >> 4 : packed & 0x0F);
+}
+
+int checkHistograms(int group, int gate)
+{
+  if (group == GROUP_COUNT)
+  {
+    for (int i = gate; i < numGatePins; i++)
+    {
+      presentCards[i] = 0;
+    }
+    countCards();
+
+    int rank = boardRank();
+    int mismatches = 0;
+    for (int level = 0; level < numLevels; level++)
+    {
+      byte packed = decisionTable[level][rank / 2];
+      int branch = (rank & 1) ? packed >> 4 : packed & 0x0F;
+      if (branch != evaluateRules(level))
+        mismatches++;
+    }
+    return mismatches;
+  }
+
+  int mismatches = 0;
+  for (int count = 0; gate + count <= numGatePins; count++)
+  {
+    for (int i = 0; i < count; i++)
+    {
+      presentCards[gate + i] = groupCategory[group];
+    }
+    mismatches += checkHistograms(group + 1, gate + count);
+  }
+  return mismatches;
+}
+
+// Compare the table with the rule chain for every histogram, so a stale
+// table falls back to evaluateBoard() instead of giving wrong outcomes
+bool checkDecisionTable()
+{
+  int mismatches = checkHistograms(0, 0);
+
+  for (int mask = 0; mask < 64; mask++)
+  {
+    for (int i = 0; i < numGatePins; i++)
+    {
+      presentCards[i] = (mask >> i) & 1 ? LINE_STRAIGHT : 0;
+    }
+    if (matchConnectionMasks() != (((validOccupancy >> mask) & 1) != 0))
+      mismatches++;
+  }
+
+  // Cards outside the histogram must reach the rules, not the table
+  const byte uncounted[] = {14, ADMIN_KEY_A};
+  for (byte category : uncounted)
+  {
+    for (int gate = 0; gate < numGatePins; gate++)
+    {
+      for (int i = 0; i < numGatePins; i++)
+      {
+        presentCards[i] = i == gate ? category : LINE_STRAIGHT;
+      }
+      countCards();
+      for (int level = 0; level < numLevels; level++)
+      {
+        if (lookupOutcome(level).branch != evaluateBoard(level).branch)
+          mismatches++;
+      }
+    }
+  }
+
+  for (int i = 0; i < numGatePins; i++)
+  {
+    presentCards[i] = 0;
+  }
+  countCards();
+
+  decisionTableValid = (mismatches == 0);
+  return decisionTableValid;
+}
+
+#endif
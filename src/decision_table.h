@@ -0,0 +1,369 @@
+// Generated by tools/gen_decision_table from src/rules.h, do not edit.
+#ifndef DECISION_TABLE_H
+#define DECISION_TABLE_H
+
+#pragma message("Decision table: 5458 bytes of flash")
+
+static_assert(numHistograms == 1716, "Decision table is out of date, run tools/gen_decision_table");
+
+// Bit n is set when occupancy mask n matches a connection mask
+const uint64_t validOccupancy = 0xFF80808080808080ULL;
+
+// Branch per level and boardRank(), two ranks per byte, even rank in the low nibble
+const byte decisionTable[6][858] = {
+    {
+        0x12,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x12,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x12,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x12,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x12,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x21,0x11,0x11,0x21,0x12,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x12,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x12,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x12,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x21,0x11,0x11,0x21,0x12,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x12,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x12,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x21,0x11,0x11,0x21,0x12,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x12,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x21,0x11,0x11,0x21,0x12,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x21,0x11,0x11,0x21,0x12,0x11,0x11,0x22,
+    },
+    {
+        0x13,0x11,0x11,0x31,0x11,0x11,0x31,0x11,0x11,0x13,0x11,0x13,0x31,0x31,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x14,0x11,0x11,0x12,0x11,0x61,0x11,
+        0x61,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x14,0x11,0x61,0x11,0x61,0x11,0x16,0x16,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x14,0x11,0x16,0x61,0x61,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x41,0x11,0x16,0x16,
+        0x11,0x11,0x11,0x11,0x14,0x16,0x41,0x13,0x11,0x11,0x13,0x11,0x31,0x11,0x31,0x11,
+        0x13,0x13,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x14,0x11,0x21,0x11,0x61,0x11,0x16,0x16,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x14,0x11,0x16,0x61,0x61,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x41,0x11,0x16,0x16,0x11,0x11,
+        0x11,0x11,0x14,0x16,0x41,0x13,0x11,0x31,0x11,0x31,0x11,0x13,0x13,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x14,0x11,0x12,0x61,0x61,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x41,0x11,0x16,0x16,0x11,0x11,0x11,
+        0x11,0x14,0x16,0x41,0x13,0x11,0x13,0x31,0x31,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x41,0x11,0x12,0x16,0x11,0x11,0x11,0x11,0x14,0x16,0x41,
+        0x13,0x31,0x31,0x11,0x11,0x11,0x11,0x41,0x21,0x11,0x34,0x31,0x11,0x34,0x13,0x11,
+        0x11,0x13,0x11,0x31,0x11,0x31,0x11,0x13,0x13,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x14,0x11,0x21,
+        0x11,0x61,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x14,0x11,0x16,0x61,0x61,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x41,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x14,0x16,0x41,0x13,0x11,0x31,0x11,
+        0x31,0x11,0x13,0x13,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x14,
+        0x11,0x12,0x61,0x61,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x41,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x14,0x16,0x41,0x13,0x11,0x13,0x31,0x31,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x41,0x11,0x12,0x16,
+        0x11,0x11,0x11,0x11,0x14,0x16,0x41,0x13,0x31,0x31,0x11,0x11,0x11,0x11,0x41,0x21,
+        0x11,0x34,0x31,0x11,0x34,0x13,0x11,0x31,0x11,0x31,0x11,0x13,0x13,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x14,0x11,0x12,0x61,0x61,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x41,0x11,0x16,0x16,0x11,0x11,0x11,
+        0x11,0x14,0x16,0x41,0x13,0x11,0x13,0x31,0x31,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x41,0x11,0x12,0x16,0x11,0x11,0x11,0x11,0x14,0x16,0x41,
+        0x13,0x31,0x31,0x11,0x11,0x11,0x11,0x41,0x21,0x11,0x34,0x31,0x11,0x34,0x13,0x11,
+        0x13,0x31,0x31,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x41,
+        0x11,0x12,0x16,0x11,0x11,0x11,0x11,0x14,0x16,0x41,0x13,0x31,0x31,0x11,0x11,0x11,
+        0x11,0x41,0x21,0x11,0x34,0x31,0x11,0x34,0x13,0x31,0x31,0x11,0x11,0x11,0x11,0x41,
+        0x21,0x11,0x34,0x31,0x11,0x34,0x13,0x13,0x41,0x33,
+    },
+    {
+        0x13,0x11,0x11,0x61,0x11,0x11,0x61,0x11,0x11,0x16,0x11,0x16,0x61,0x61,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x11,0x15,0x11,0x51,
+        0x11,0x51,0x11,0x15,0x15,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x61,0x11,0x61,0x11,0x16,0x16,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x61,0x11,0x16,0x16,0x11,0x11,0x11,
+        0x11,0x31,0x11,0x16,0x16,0x11,0x31,0x61,0x31,0x13,0x11,0x11,0x14,0x11,0x61,0x11,
+        0x61,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x21,0x11,0x61,0x11,0x16,0x16,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x61,0x11,0x16,0x16,0x11,0x11,0x11,0x11,
+        0x31,0x11,0x16,0x16,0x11,0x31,0x61,0x31,0x13,0x11,0x61,0x11,0x61,0x11,0x16,0x16,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x61,0x11,0x16,0x16,0x11,
+        0x11,0x11,0x11,0x31,0x11,0x16,0x16,0x11,0x31,0x61,0x31,0x13,0x11,0x16,0x61,0x61,
+        0x11,0x11,0x11,0x11,0x11,0x13,0x61,0x61,0x11,0x11,0x13,0x16,0x33,0x11,0x16,0x16,
+        0x11,0x31,0x61,0x31,0x13,0x16,0x33,0x13,0x11,0x11,0x16,0x11,0x61,0x11,0x61,0x11,
+        0x16,0x16,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x13,0x11,0x51,0x11,0x51,0x11,0x15,0x15,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x31,0x11,0x61,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x31,0x11,
+        0x16,0x16,0x11,0x31,0x61,0x31,0x13,0x11,0x41,0x11,0x61,0x11,0x16,0x16,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x21,0x11,0x16,0x16,0x11,0x11,0x11,
+        0x11,0x31,0x11,0x16,0x16,0x11,0x31,0x61,0x31,0x13,0x11,0x16,0x61,0x61,0x11,0x11,
+        0x11,0x11,0x11,0x13,0x61,0x61,0x11,0x11,0x13,0x16,0x33,0x11,0x16,0x16,0x11,0x31,
+        0x61,0x31,0x13,0x16,0x33,0x13,0x11,0x61,0x11,0x61,0x11,0x16,0x16,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x51,0x11,0x15,0x15,0x11,0x11,0x11,0x11,
+        0x31,0x11,0x16,0x16,0x11,0x31,0x61,0x31,0x13,0x11,0x14,0x61,0x61,0x11,0x11,0x11,
+        0x11,0x11,0x13,0x21,0x61,0x11,0x11,0x13,0x16,0x33,0x11,0x16,0x16,0x11,0x31,0x61,
+        0x31,0x13,0x16,0x33,0x13,0x11,0x16,0x61,0x61,0x11,0x11,0x11,0x11,0x11,0x13,0x51,
+        0x51,0x11,0x11,0x13,0x16,0x33,0x11,0x14,0x16,0x11,0x31,0x21,0x31,0x13,0x16,0x33,
+        0x13,0x61,0x61,0x11,0x11,0x13,0x15,0x33,0x41,0x31,0x33,0x61,0x31,0x33,0x13,0x11,
+        0x11,0x16,0x11,0x61,0x11,0x61,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x51,0x11,0x51,0x11,
+        0x15,0x15,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x61,0x11,0x16,
+        0x16,0x11,0x11,0x11,0x11,0x31,0x11,0x16,0x16,0x11,0x31,0x61,0x31,0x13,0x11,0x41,
+        0x11,0x61,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,
+        0x21,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x31,0x11,0x16,0x16,0x11,0x31,0x61,0x31,
+        0x13,0x11,0x16,0x61,0x61,0x11,0x11,0x11,0x11,0x11,0x13,0x61,0x61,0x11,0x11,0x13,
+        0x16,0x33,0x11,0x16,0x16,0x11,0x31,0x61,0x31,0x13,0x16,0x33,0x13,0x11,0x61,0x11,
+        0x61,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x51,
+        0x11,0x15,0x15,0x11,0x11,0x11,0x11,0x31,0x11,0x16,0x16,0x11,0x31,0x61,0x31,0x13,
+        0x11,0x14,0x61,0x61,0x11,0x11,0x11,0x11,0x11,0x13,0x21,0x61,0x11,0x11,0x13,0x16,
+        0x33,0x11,0x16,0x16,0x11,0x31,0x61,0x31,0x13,0x16,0x33,0x13,0x11,0x16,0x61,0x61,
+        0x11,0x11,0x11,0x11,0x11,0x13,0x51,0x51,0x11,0x11,0x13,0x16,0x33,0x11,0x14,0x16,
+        0x11,0x31,0x21,0x31,0x13,0x16,0x33,0x13,0x61,0x61,0x11,0x11,0x13,0x15,0x33,0x41,
+        0x31,0x33,0x61,0x31,0x33,0x13,0x11,0x61,0x11,0x61,0x11,0x16,0x16,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x51,0x11,0x15,0x15,0x11,0x11,0x11,0x11,
+        0x31,0x11,0x16,0x16,0x11,0x31,0x61,0x31,0x13,0x11,0x14,0x61,0x61,0x11,0x11,0x11,
+        0x11,0x11,0x13,0x21,0x61,0x11,0x11,0x13,0x16,0x33,0x11,0x16,0x16,0x11,0x31,0x61,
+        0x31,0x13,0x16,0x33,0x13,0x11,0x16,0x61,0x61,0x11,0x11,0x11,0x11,0x11,0x13,0x51,
+        0x51,0x11,0x11,0x13,0x16,0x33,0x11,0x14,0x16,0x11,0x31,0x21,0x31,0x13,0x16,0x33,
+        0x13,0x61,0x61,0x11,0x11,0x13,0x15,0x33,0x41,0x31,0x33,0x61,0x31,0x33,0x13,0x11,
+        0x16,0x61,0x61,0x11,0x11,0x11,0x11,0x11,0x13,0x51,0x51,0x11,0x11,0x13,0x16,0x33,
+        0x11,0x14,0x16,0x11,0x31,0x21,0x31,0x13,0x16,0x33,0x13,0x61,0x61,0x11,0x11,0x13,
+        0x15,0x33,0x41,0x31,0x33,0x61,0x31,0x33,0x13,0x61,0x61,0x11,0x11,0x13,0x15,0x33,
+        0x41,0x31,0x33,0x61,0x31,0x33,0x13,0x16,0x33,0x33,
+    },
+    {
+        0x13,0x11,0x11,0x51,0x11,0x11,0x51,0x11,0x11,0x15,0x11,0x15,0x51,0x51,0x13,0x11,
+        0x11,0x16,0x11,0x61,0x11,0x61,0x11,0x16,0x36,0x11,0x11,0x16,0x11,0x16,0x61,0x61,
+        0x13,0x11,0x16,0x61,0x61,0x13,0x61,0x61,0x13,0x36,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x11,0x15,0x11,0x51,0x11,
+        0x51,0x11,0x15,0x35,0x11,0x11,0x12,0x11,0x16,0x61,0x61,0x13,0x11,0x16,0x61,0x61,
+        0x13,0x61,0x61,0x13,0x36,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x51,0x11,0x51,0x11,0x15,0x35,
+        0x11,0x61,0x11,0x16,0x36,0x11,0x16,0x36,0x61,0x13,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x15,0x51,0x51,
+        0x13,0x61,0x61,0x13,0x36,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x15,0x35,
+        0x61,0x13,0x11,0x11,0x13,0x35,0x31,0x13,0x11,0x11,0x15,0x11,0x51,0x11,0x51,0x11,
+        0x15,0x35,0x11,0x11,0x16,0x11,0x16,0x61,0x61,0x13,0x11,0x16,0x61,0x61,0x13,0x61,
+        0x61,0x13,0x36,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x51,0x11,0x51,0x11,0x15,0x35,0x11,0x21,
+        0x11,0x16,0x36,0x11,0x16,0x36,0x61,0x13,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x15,0x51,0x51,0x13,0x61,
+        0x61,0x13,0x36,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x15,0x35,0x61,0x13,
+        0x11,0x11,0x13,0x35,0x31,0x13,0x11,0x51,0x11,0x51,0x11,0x15,0x35,0x11,0x61,0x11,
+        0x16,0x36,0x11,0x16,0x36,0x61,0x13,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x15,0x51,0x51,0x13,0x21,0x61,
+        0x13,0x36,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x15,0x35,0x61,0x13,0x11,
+        0x11,0x13,0x35,0x31,0x13,0x11,0x15,0x51,0x51,0x13,0x61,0x61,0x13,0x36,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x15,0x35,0x21,0x13,0x11,0x11,0x13,0x35,0x31,
+        0x13,0x51,0x51,0x13,0x36,0x11,0x11,0x31,0x51,0x13,0x33,0x51,0x13,0x33,0x13,0x11,
+        0x11,0x15,0x11,0x51,0x11,0x51,0x11,0x15,0x35,0x11,0x11,0x16,0x11,0x16,0x61,0x61,
+        0x13,0x11,0x16,0x61,0x61,0x13,0x61,0x61,0x13,0x36,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x51,
+        0x11,0x51,0x11,0x15,0x35,0x11,0x21,0x11,0x16,0x36,0x11,0x16,0x36,0x61,0x13,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x13,0x11,0x15,0x51,0x51,0x13,0x61,0x61,0x13,0x36,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x31,0x11,0x15,0x35,0x61,0x13,0x11,0x11,0x13,0x35,0x31,0x13,0x11,0x51,0x11,
+        0x51,0x11,0x15,0x35,0x11,0x61,0x11,0x16,0x36,0x11,0x16,0x36,0x61,0x13,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,
+        0x11,0x15,0x51,0x51,0x13,0x21,0x61,0x13,0x36,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x31,0x11,0x15,0x35,0x61,0x13,0x11,0x11,0x13,0x35,0x31,0x13,0x11,0x15,0x51,0x51,
+        0x13,0x61,0x61,0x13,0x36,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x15,0x35,
+        0x21,0x13,0x11,0x11,0x13,0x35,0x31,0x13,0x51,0x51,0x13,0x36,0x11,0x11,0x31,0x51,
+        0x13,0x33,0x51,0x13,0x33,0x13,0x11,0x51,0x11,0x51,0x11,0x15,0x35,0x11,0x61,0x11,
+        0x16,0x36,0x11,0x16,0x36,0x61,0x13,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x15,0x51,0x51,0x13,0x21,0x61,
+        0x13,0x36,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x15,0x35,0x61,0x13,0x11,
+        0x11,0x13,0x35,0x31,0x13,0x11,0x15,0x51,0x51,0x13,0x61,0x61,0x13,0x36,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x15,0x35,0x21,0x13,0x11,0x11,0x13,0x35,0x31,
+        0x13,0x51,0x51,0x13,0x36,0x11,0x11,0x31,0x51,0x13,0x33,0x51,0x13,0x33,0x13,0x11,
+        0x15,0x51,0x51,0x13,0x61,0x61,0x13,0x36,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,
+        0x11,0x15,0x35,0x21,0x13,0x11,0x11,0x13,0x35,0x31,0x13,0x51,0x51,0x13,0x36,0x11,
+        0x11,0x31,0x51,0x13,0x33,0x51,0x13,0x33,0x13,0x51,0x51,0x13,0x36,0x11,0x11,0x31,
+        0x51,0x13,0x33,0x51,0x13,0x33,0x13,0x35,0x31,0x33,
+    },
+    {
+        0x13,0x11,0x11,0x61,0x11,0x11,0x61,0x11,0x11,0x16,0x11,0x16,0x61,0x61,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x11,0x15,0x11,0x51,0x11,
+        0x51,0x11,0x15,0x15,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x41,0x11,0x21,0x11,0x16,0x16,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x16,0x61,0x61,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x16,0x16,
+        0x11,0x11,0x11,0x11,0x13,0x16,0x31,0x13,0x11,0x11,0x16,0x11,0x61,0x11,0x61,0x11,
+        0x16,0x16,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x51,0x11,0x51,0x11,0x15,0x15,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x14,0x21,0x61,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x16,0x16,0x11,0x11,
+        0x11,0x11,0x13,0x16,0x31,0x13,0x11,0x61,0x11,0x61,0x11,0x16,0x16,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x15,0x51,0x51,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x14,0x12,0x11,0x11,0x11,
+        0x11,0x13,0x16,0x31,0x13,0x11,0x16,0x61,0x61,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x15,0x15,0x11,0x11,0x11,0x11,0x13,0x14,0x31,
+        0x13,0x61,0x61,0x11,0x11,0x11,0x11,0x31,0x51,0x11,0x33,0x61,0x11,0x33,0x13,0x11,
+        0x11,0x16,0x11,0x61,0x11,0x61,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x51,
+        0x11,0x51,0x11,0x15,0x15,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x13,0x11,0x14,0x21,0x61,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x31,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x13,0x16,0x31,0x13,0x11,0x61,0x11,
+        0x61,0x11,0x16,0x16,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,
+        0x11,0x15,0x51,0x51,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x31,0x11,0x14,0x12,0x11,0x11,0x11,0x11,0x13,0x16,0x31,0x13,0x11,0x16,0x61,0x61,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x15,0x15,
+        0x11,0x11,0x11,0x11,0x13,0x14,0x31,0x13,0x61,0x61,0x11,0x11,0x11,0x11,0x31,0x51,
+        0x11,0x33,0x61,0x11,0x33,0x13,0x11,0x61,0x11,0x61,0x11,0x16,0x16,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x13,0x11,0x15,0x51,0x51,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x14,0x12,0x11,0x11,0x11,
+        0x11,0x13,0x16,0x31,0x13,0x11,0x16,0x61,0x61,0x11,0x11,0x11,0x11,0x11,0x11,0x11,
+        0x11,0x11,0x11,0x11,0x11,0x31,0x11,0x15,0x15,0x11,0x11,0x11,0x11,0x13,0x14,0x31,
+        0x13,0x61,0x61,0x11,0x11,0x11,0x11,0x31,0x51,0x11,0x33,0x61,0x11,0x33,0x13,0x11,
+        0x16,0x61,0x61,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x31,
+        0x11,0x15,0x15,0x11,0x11,0x11,0x11,0x13,0x14,0x31,0x13,0x61,0x61,0x11,0x11,0x11,
+        0x11,0x31,0x51,0x11,0x33,0x61,0x11,0x33,0x13,0x61,0x61,0x11,0x11,0x11,0x11,0x31,
+        0x51,0x11,0x33,0x61,0x11,0x33,0x13,0x16,0x31,0x33,
+    },
+    {
+        0x33,0x33,0x33,0x43,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x33,0x33,
+        0x33,0x54,0x55,0x45,0x55,0x45,0x55,0x54,0x34,0x33,0x33,0x54,0x55,0x54,0x45,0x45,
+        0x33,0x33,0x54,0x45,0x45,0x33,0x43,0x45,0x33,0x34,0x33,0x33,0x33,0x44,0x44,0x44,
+        0x44,0x44,0x44,0x44,0x34,0x33,0x33,0x54,0x55,0x54,0x45,0x45,0x33,0x33,0x54,0x45,
+        0x45,0x33,0x43,0x45,0x33,0x34,0x33,0x33,0x43,0x44,0x44,0x44,0x44,0x34,0x33,0x43,
+        0x55,0x54,0x34,0x33,0x54,0x34,0x43,0x33,0x33,0x43,0x44,0x44,0x34,0x33,0x54,0x34,
+        0x43,0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x33,0x33,0x44,0x44,0x44,0x44,
+        0x44,0x44,0x44,0x34,0x33,0x33,0x54,0x55,0x54,0x45,0x45,0x33,0x33,0x54,0x45,0x45,
+        0x33,0x43,0x45,0x33,0x34,0x33,0x33,0x43,0x44,0x44,0x44,0x44,0x34,0x33,0x43,0x55,
+        0x54,0x34,0x33,0x54,0x34,0x43,0x33,0x33,0x43,0x44,0x44,0x34,0x33,0x54,0x34,0x43,
+        0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x33,0x43,0x44,0x44,0x44,0x44,0x34,
+        0x33,0x43,0x55,0x54,0x34,0x33,0x54,0x34,0x43,0x33,0x33,0x43,0x44,0x44,0x34,0x33,
+        0x54,0x34,0x43,0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x33,0x44,0x44,0x44,
+        0x33,0x43,0x45,0x33,0x34,0x33,0x43,0x44,0x33,0x34,0x33,0x34,0x33,0x33,0x44,0x34,
+        0x43,0x33,0x43,0x33,0x33,0x34,0x33,0x33,0x33,0x33,0x44,0x44,0x44,0x44,0x44,0x44,
+        0x44,0x34,0x33,0x33,0x64,0x66,0x64,0x46,0x46,0x33,0x33,0x64,0x46,0x46,0x33,0x43,
+        0x46,0x33,0x34,0x33,0x33,0x43,0x44,0x44,0x44,0x44,0x34,0x33,0x43,0x66,0x64,0x34,
+        0x33,0x64,0x34,0x43,0x33,0x33,0x43,0x44,0x44,0x34,0x33,0x64,0x34,0x43,0x33,0x33,
+        0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x33,0x43,0x44,0x44,0x44,0x44,0x34,0x33,0x43,
+        0x62,0x64,0x34,0x33,0x64,0x34,0x43,0x33,0x33,0x43,0x44,0x44,0x34,0x33,0x24,0x34,
+        0x43,0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x33,0x44,0x44,0x44,0x33,0x43,
+        0x46,0x33,0x34,0x33,0x43,0x44,0x33,0x34,0x33,0x34,0x33,0x33,0x44,0x34,0x43,0x33,
+        0x43,0x33,0x33,0x34,0x33,0x33,0x33,0x43,0x44,0x44,0x44,0x44,0x34,0x33,0x43,0x66,
+        0x64,0x34,0x33,0x64,0x34,0x43,0x33,0x33,0x43,0x44,0x44,0x34,0x33,0x64,0x34,0x43,
+        0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x33,0x44,0x44,0x44,0x33,0x43,0x46,
+        0x33,0x34,0x33,0x43,0x44,0x33,0x34,0x33,0x34,0x33,0x33,0x44,0x34,0x43,0x33,0x43,
+        0x33,0x33,0x34,0x33,0x33,0x33,0x44,0x44,0x44,0x33,0x43,0x46,0x33,0x34,0x33,0x43,
+        0x44,0x33,0x34,0x33,0x34,0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x34,0x33,
+        0x33,0x43,0x44,0x33,0x34,0x33,0x34,0x33,0x43,0x33,0x33,0x43,0x33,0x33,0x33,0x33,
+        0x33,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x34,0x33,0x33,0x54,0x55,0x54,0x45,0x45,
+        0x33,0x33,0x54,0x45,0x45,0x33,0x43,0x45,0x33,0x34,0x33,0x33,0x43,0x44,0x44,0x44,
+        0x44,0x34,0x33,0x43,0x55,0x54,0x34,0x33,0x54,0x34,0x43,0x33,0x33,0x43,0x44,0x44,
+        0x34,0x33,0x54,0x34,0x43,0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x33,0x43,
+        0x44,0x44,0x44,0x44,0x34,0x33,0x43,0x55,0x54,0x34,0x33,0x54,0x34,0x43,0x33,0x33,
+        0x43,0x44,0x44,0x34,0x33,0x54,0x34,0x43,0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,
+        0x33,0x33,0x44,0x44,0x44,0x33,0x43,0x45,0x33,0x34,0x33,0x43,0x44,0x33,0x34,0x33,
+        0x34,0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x34,0x33,0x33,0x33,0x43,0x44,
+        0x44,0x44,0x44,0x34,0x33,0x43,0x66,0x64,0x34,0x33,0x64,0x34,0x43,0x33,0x33,0x43,
+        0x44,0x44,0x34,0x33,0x64,0x34,0x43,0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,
+        0x33,0x44,0x44,0x44,0x33,0x43,0x42,0x33,0x34,0x33,0x43,0x44,0x33,0x34,0x33,0x34,
+        0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x34,0x33,0x33,0x33,0x44,0x44,0x44,
+        0x33,0x43,0x46,0x33,0x34,0x33,0x43,0x44,0x33,0x34,0x33,0x34,0x33,0x33,0x44,0x34,
+        0x43,0x33,0x43,0x33,0x33,0x34,0x33,0x33,0x43,0x44,0x33,0x34,0x33,0x34,0x33,0x43,
+        0x33,0x33,0x43,0x33,0x33,0x33,0x33,0x43,0x44,0x44,0x44,0x44,0x34,0x33,0x43,0x55,
+        0x54,0x34,0x33,0x54,0x34,0x43,0x33,0x33,0x43,0x44,0x44,0x34,0x33,0x54,0x34,0x43,
+        0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x33,0x44,0x44,0x44,0x33,0x43,0x45,
+        0x33,0x34,0x33,0x43,0x44,0x33,0x34,0x33,0x34,0x33,0x33,0x44,0x34,0x43,0x33,0x43,
+        0x33,0x33,0x34,0x33,0x33,0x33,0x44,0x44,0x44,0x33,0x43,0x46,0x33,0x34,0x33,0x43,
+        0x44,0x33,0x34,0x33,0x34,0x33,0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x34,0x33,
+        0x33,0x43,0x44,0x33,0x34,0x33,0x34,0x33,0x43,0x33,0x33,0x43,0x33,0x33,0x33,0x33,
+        0x44,0x44,0x44,0x33,0x43,0x45,0x33,0x34,0x33,0x43,0x44,0x33,0x34,0x33,0x34,0x33,
+        0x33,0x44,0x34,0x43,0x33,0x43,0x33,0x33,0x34,0x33,0x33,0x43,0x44,0x33,0x34,0x33,
+        0x34,0x33,0x43,0x33,0x33,0x43,0x33,0x33,0x33,0x43,0x44,0x33,0x34,0x33,0x34,0x33,
+        0x43,0x33,0x33,0x43,0x33,0x33,0x33,0x34,0x33,0x33,
+    },
+};
+
+// Group counts of every histogram that completes a level, 3 bits per group
+// with group 0 lowest. Level n owns winningHistograms[winningStart[n]] up to
+// winningStart[n + 1].
+const uint32_t winningHistograms[72] = {
+    0x000000,0x000008,0x000010,0x000018,0x000020,0x000028,0x000030,0x000001,
+    0x000009,0x000011,0x000019,0x000021,0x000029,0x000002,0x00000A,0x000012,
+    0x00001A,0x000022,0x000003,0x00000B,0x000013,0x00001B,0x000004,0x00000C,
+    0x000014,0x000005,0x00000D,0x000006,0x008040,0x008048,0x008050,0x008058,
+    0x008060,0x008041,0x008049,0x008051,0x008059,0x008042,0x00804A,0x008052,
+    0x008043,0x00804B,0x008044,0x008240,0x008248,0x008250,0x008258,0x008241,
+    0x008249,0x008251,0x008242,0x00824A,0x008243,0x009040,0x009048,0x009050,
+    0x009058,0x009041,0x009049,0x009051,0x009042,0x00904A,0x009043,0x010080,
+    0x010088,0x010090,0x010081,0x010089,0x010082,0x049048,0x049248,0x049049,
+};
+
+const uint16_t winningStart[7] = {0, 28, 43, 53, 63, 69, 72};
+
+#endif
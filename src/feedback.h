@@ -0,0 +1,94 @@
+#ifndef FEEDBACK_H
+#define FEEDBACK_H
+
+#include "leds.h"
+#include "speculate.h"
+#include "tables.h"
+
+// Feedback while a press is being scanned. The press starts a short
+// acknowledgement from folder 04 and darkens the LEDs of the table; as the
+// sweep reads each gate, the LED of a gate whose tile was recognised fades in.
+// Both only hand work to the LED alarm and the player UART, so the sweep never
+// waits for them. Once the verdict is known the LEDs go back to the level
+// progress they showed before, and the cues of the verdict take over.
+
+bool FEEDBACK = true; // Scan feedback on the LEDs and the player
+
+const byte ackFolder = 4;
+const byte ackTrack = 1;
+const signed char gateLeds[numGatePins] = {0, 1, 2, 3, 4, -1}; // LED of each gate, -1 for none
+const LedEffect feedbackClear = {EFFECT_FADE, 0, 80, 1, 0};
+
+// Counters for STATS
+unsigned long acksPlayed = 0;
+unsigned long acksSkipped = 0; // A pre-armed verdict track follows at once
+unsigned long gatesShown = 0;
+
+// The sweep of the active table starts
+void feedbackStart()
+{
+  if (!FEEDBACK)
+    return;
+
+  Table &t = *table;
+  int base = activeTable * numLeds;
+  uint32_t now = micros();
+  for (int i = 0; i < numLeds; i++)
+  {
+    t.ledsBefore[i] = ledFrame[base + i];
+    startEffect(base + i, feedbackClear, now);
+  }
+
+  // The acknowledgement would replace a pre-armed verdict track, which
+  // starts without a seek as soon as the sweep is done. Only when that track
+  // is the verdict of the board still on the table; a stale one is replaced
+  // anyway.
+  if (t.specValid && t.specLevel == currentLevel && t.armStep == ARM_READY &&
+      t.armCue == verdictCue(t.specOutcome))
+  {
+    acksSkipped++;
+    return;
+  }
+  cancelArm(t);
+  t.hw.player->playSpecific(ackFolder, ackTrack);
+  acksPlayed++;
+}
+
+// A gate of the active table was read, by the sweep or a confirming read
+void feedbackGate(int gate, byte category)
+{
+  if (!FEEDBACK || category == 0 || gateLeds[gate] < 0)
+    return;
+  startEffect(activeTable * numLeds + gateLeds[gate], ledFadeOn, micros());
+  gatesShown++;
+}
+
+// The verdict of the active table is known
+void feedbackDone()
+{
+  if (!FEEDBACK)
+    return;
+
+  const Table &t = *table;
+  int base = activeTable * numLeds;
+  uint32_t now = micros();
+  for (int i = 0; i < numLeds; i++)
+  {
+    LedEffect restore = {EFFECT_FADE, t.ledsBefore[i], 150, 1, t.ledsBefore[i]};
+    startEffect(base + i, restore, now);
+  }
+}
+
+void printFeedbackStats()
+{
+  Serial.print("Scan feedback: ");
+  Serial.print(FEEDBACK ? "on" : "off");
+  Serial.print(", acknowledgements ");
+  Serial.print(acksPlayed);
+  Serial.print(", skipped for a pre-armed track ");
+  Serial.print(acksSkipped);
+  Serial.print(", gates shown ");
+  Serial.println(gatesShown);
+}
+
+#endif
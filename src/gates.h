@@ -0,0 +1,158 @@
+#ifndef GATES_H
+#define GATES_H
+
+#include <MFRC522.h>
+#include <hardware/gpio.h>
+#include "recovery.h"
+#include "rules.h"
+
+// Gate multiplexer: switches the reader to one gate at a time. All gate lines
+// change in a single SIO write, and the time a gate needs before the reader
+// answers is measured per gate instead of waiting a fixed 20 ms.
+
+// Boards driven by this controller, they share the reader
+const int numTables = 1;
+const int numGates = numTables * numGatePins;
+
+// Gate lines of every table, numGatePins per table
+const int gatePins[] = {22, 20, 17, 27, 28, 26};
+static_assert(sizeof(gatePins) / sizeof(gatePins[0]) == numGates, "Every table needs numGatePins gate pins");
+
+const unsigned long defaultSettleUs = 20000; // Used until a gate is calibrated
+const unsigned long minSettleUs = 1000;      // Never wait less than this
+const unsigned long maxCalibrationUs = 20000;
+const int calibrationRuns = 3;
+
+int activeTable = 0; // Table whose game state is in the globals, see tables.h
+
+// Gate of the active table as numbered here
+int tableGate(int gate)
+{
+  return activeTable * numGatePins + gate;
+}
+
+uint32_t gateMask = 0;                        // SIO bits of all gate pins
+unsigned long gateSettleUs[numGates];         // Wait after opening each gate
+unsigned long gateBreakUs = defaultSettleUs;  // Wait after closing all gates
+bool calibrateOnBoot = true;
+
+// delayMicroseconds() that keeps the watchdog fed
+void waitUs(unsigned long us)
+{
+  unsigned long start = micros();
+  while (micros() - start < us)
+  {
+    feedWatchdog();
+  }
+}
+
+void initGates()
+{
+  gateMask = 0;
+  for (int i = 0; i < numGates; i++)
+  {
+    gateMask |= 1UL << gatePins[i];
+    gateSettleUs[i] = defaultSettleUs;
+  }
+
+  gpio_init_mask(gateMask);
+  gpio_set_dir_out_masked(gateMask);
+  gpio_clr_mask(gateMask); // All gates closed
+}
+
+void closeGates()
+{
+  gpio_clr_mask(gateMask);
+}
+
+// Break before make: close every gate, wait for the lines to drop, then open
+// the requested gate in one masked write
+void openGate(int gate)
+{
+  closeGates();
+  waitUs(gateBreakUs);
+  gpio_put_masked(gateMask, 1UL << gatePins[gate]);
+}
+
+// Wait until the gate opened by openGate() is usable
+void settleGate(int gate)
+{
+  waitUs(gateSettleUs[gate]);
+}
+
+bool readerAnswers(MFRC522 &reader)
+{
+  byte version = reader.PCD_ReadRegister(MFRC522::VersionReg);
+  return version != 0x00 && version != 0xFF;
+}
+
+// Microseconds until readerAnswers() returns want, or 0 when it never does
+unsigned long measureUntil(MFRC522 &reader, bool want)
+{
+  unsigned long start = micros();
+  while (micros() - start < maxCalibrationUs)
+  {
+    feedWatchdog();
+    if (readerAnswers(reader) == want)
+    {
+      unsigned long elapsed = micros() - start;
+      return elapsed > 0 ? elapsed : 1;
+    }
+  }
+  return 0;
+}
+
+// Measure per gate how long the reader takes to answer after the gate opens
+// and to go quiet after it closes. Waits get a 50% margin, gates that never
+// answer keep the default.
+void calibrateGates(MFRC522 &reader)
+{
+  unsigned long longestBreak = 0;
+
+  for (int gate = 0; gate < numGates; gate++)
+  {
+    unsigned long longestSettle = 0;
+    bool answered = true;
+
+    for (int run = 0; run < calibrationRuns && answered; run++)
+    {
+      closeGates();
+      waitUs(maxCalibrationUs);
+      gpio_put_masked(gateMask, 1UL << gatePins[gate]);
+
+      unsigned long settle = measureUntil(reader, true);
+      if (settle == 0)
+      {
+        answered = false;
+        break;
+      }
+      if (settle > longestSettle)
+        longestSettle = settle;
+
+      closeGates();
+      unsigned long release = measureUntil(reader, false);
+      if (release > longestBreak)
+        longestBreak = release;
+    }
+
+    gateSettleUs[gate] = answered ? max(minSettleUs, longestSettle * 3 / 2) : defaultSettleUs;
+  }
+
+  gateBreakUs = longestBreak > 0 ? max(minSettleUs, longestBreak * 3 / 2) : defaultSettleUs;
+  closeGates();
+}
+
+void printGateTiming()
+{
+  Serial.print("Gate break: ");
+  Serial.print(gateBreakUs);
+  Serial.print(" us, settle:");
+  for (int i = 0; i < numGates; i++)
+  {
+    Serial.print(" ");
+    Serial.print(gateSettleUs[i]);
+  }
+  Serial.println(" us");
+}
+
+#endif
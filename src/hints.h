@@ -0,0 +1,244 @@
+#ifndef HINTS_H
+#define HINTS_H
+
+#include "decision.h"
+
+// Hint engine: finds the fewest tile edits (add, remove or swap one tile)
+// that turn the board into one that completes the level. A winning board is
+// a valid occupancy mask plus a group histogram from winningHistograms, so
+// the search only compares group counts: removes and adds follow from the
+// mask, swaps are the kept tiles whose group is over-represented.
+
+enum HintAction
+{
+  HINT_NONE,   // Board already completes the level, or no hint is known
+  HINT_ADD,    // Place a tile of group on gate
+  HINT_REMOVE, // Take the tile off gate
+  HINT_SWAP    // Replace the tile on gate by one of group
+};
+
+struct Hint
+{
+  byte distance; // Edits to the nearest winning board
+  byte action;   // First edit
+  byte gate;
+  byte group;
+};
+
+const byte hintFolder = 2;      // Action and gate: add 1-6, remove 11-16, swap 21-26
+const byte hintGroupFolder = 3; // Group to add or swap in: track group + 1
+
+bool hintsValid = false;        // Set once the winning histograms agree with the rules
+unsigned long hintsGiven = 0;
+unsigned long lastHintUs = 0;   // Duration of the last search
+
+byte wantedCount(uint32_t packed, int group)
+{
+  return (packed >> (3 * group)) & 7;
+}
+
+// Group of a category, GROUP_COUNT when it is in none
+byte categoryGroup(byte category)
+{
+  for (int g = 0; g < GROUP_COUNT; g++)
+  {
+    if (category >= 1 && category <= 13 && (groupMasks[g] & categoryBits(category)))
+      return g;
+  }
+  return GROUP_COUNT;
+}
+
+// Group counts of the tiles on the gates in mask
+void maskCounts(byte mask, byte counts[GROUP_COUNT + 1])
+{
+  for (int g = 0; g <= GROUP_COUNT; g++)
+  {
+    counts[g] = 0;
+  }
+  for (int i = 0; i < numGatePins; i++)
+  {
+    if ((mask >> i) & 1)
+      counts[categoryGroup(presentCards[i])]++;
+  }
+}
+
+// First edit towards the winning board given by mask and histogram
+void firstEdit(byte mask, uint32_t packed, Hint &hint)
+{
+  byte occupied = occupancyMask();
+  byte counts[GROUP_COUNT + 1];
+  maskCounts(occupied & mask, counts);
+
+  int missing = GROUP_COUNT; // A group the target has more of than the kept tiles
+  for (int g = 0; g < GROUP_COUNT && missing == GROUP_COUNT; g++)
+  {
+    if (wantedCount(packed, g) > counts[g])
+      missing = g;
+  }
+
+  for (int i = 0; i < numGatePins; i++)
+  {
+    if (((occupied & ~mask) >> i) & 1)
+    {
+      hint.action = HINT_REMOVE;
+      hint.gate = i;
+      return;
+    }
+  }
+
+  for (int i = 0; i < numGatePins; i++)
+  {
+    byte group = categoryGroup(presentCards[i]);
+    if (((occupied >> i) & 1) && (group == GROUP_COUNT || counts[group] > wantedCount(packed, group)))
+    {
+      hint.action = HINT_SWAP;
+      hint.gate = i;
+      hint.group = missing;
+      return;
+    }
+  }
+
+  for (int i = 0; i < numGatePins; i++)
+  {
+    if (((mask & ~occupied) >> i) & 1)
+    {
+      hint.action = HINT_ADD;
+      hint.gate = i;
+      hint.group = missing;
+      return;
+    }
+  }
+}
+
+// Nearest winning board of level for presentCards
+Hint findHint(int level)
+{
+  Hint hint = {0, HINT_NONE, 0, 0};
+  if (!hintsValid || level < 0 || level >= numLevels)
+    return hint;
+
+  unsigned long start = micros();
+  byte occupied = occupancyMask();
+  int best = numGatePins * 2 + 1;
+  byte bestMask = 0;
+  uint32_t bestPacked = 0;
+
+  for (int mask = 1; mask < 64; mask++)
+  {
+    if (((validOccupancy >> mask) & 1) == 0)
+      continue;
+
+    int size = __builtin_popcount(mask);
+    int removes = __builtin_popcount(occupied & ~mask);
+    int adds = __builtin_popcount(mask & ~occupied);
+    int kept = __builtin_popcount(occupied & mask);
+    if (removes + adds >= best)
+      continue;
+
+    byte counts[GROUP_COUNT + 1];
+    maskCounts(occupied & mask, counts);
+
+    for (int w = winningStart[level]; w < winningStart[level + 1]; w++)
+    {
+      uint32_t packed = winningHistograms[w];
+      int total = 0;
+      int matched = 0;
+      for (int g = 0; g < GROUP_COUNT; g++)
+      {
+        byte want = wantedCount(packed, g);
+        total += want;
+        matched += want < counts[g] ? want : counts[g];
+      }
+      if (total != size)
+        continue;
+
+      int distance = removes + adds + kept - matched;
+      if (distance < best)
+      {
+        best = distance;
+        bestMask = mask;
+        bestPacked = packed;
+      }
+    }
+  }
+
+  if (best <= numGatePins * 2)
+  {
+    hint.distance = best;
+    if (best > 0)
+      firstEdit(bestMask, bestPacked, hint);
+  }
+  lastHintUs = micros() - start;
+  return hint;
+}
+
+// Compare the winning histograms with the rule chain, like checkDecisionTable()
+bool checkHints()
+{
+  int mismatches = 0;
+
+  for (int level = 0; level < numLevels; level++)
+  {
+    int winning = 0;
+    for (int rank = 0; rank < numHistograms; rank++)
+    {
+      byte packed = decisionTable[level][rank / 2];
+      if (((rank & 1) ? packed >> 4 : packed & 0x0F) == BRANCH_RULE_0)
+        winning++;
+    }
+    if (winning != winningStart[level + 1] - winningStart[level])
+      mismatches++;
+
+    for (int w = winningStart[level]; w < winningStart[level + 1]; w++)
+    {
+      int gate = 0;
+      for (int g = 0; g < GROUP_COUNT; g++)
+      {
+        for (int c = 0; c < wantedCount(winningHistograms[w], g) && gate < numGatePins; c++)
+        {
+          presentCards[gate++] = groupCategory[g];
+        }
+      }
+      while (gate < numGatePins)
+      {
+        presentCards[gate++] = 0;
+      }
+      countCards();
+      if (evaluateRules(level) != BRANCH_RULE_0)
+        mismatches++;
+    }
+  }
+
+  for (int i = 0; i < numGatePins; i++)
+  {
+    presentCards[i] = 0;
+  }
+  countCards();
+
+  hintsValid = decisionTableValid && mismatches == 0;
+  return hintsValid;
+}
+
+void printHint(const Hint &hint)
+{
+  static const char *actions[] = {"none", "add", "remove", "swap"};
+  Serial.print("Hint: ");
+  Serial.print(hint.distance);
+  Serial.print(" edits away, ");
+  Serial.print(actions[hint.action]);
+  if (hint.action != HINT_NONE)
+  {
+    Serial.print(" at gate ");
+    Serial.print(hint.gate + 1);
+  }
+  if (hint.action == HINT_ADD || hint.action == HINT_SWAP)
+  {
+    Serial.print(", group ");
+    Serial.print(hint.group);
+  }
+  Serial.print(" (");
+  Serial.print(lastHintUs);
+  Serial.println(" us)");
+}
+
+#endif
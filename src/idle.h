@@ -0,0 +1,128 @@
+#ifndef IDLE_H
+#define IDLE_H
+
+#include <hardware/sync.h>
+#include <pico/time.h>
+#include "recovery.h"
+#include "reader.h"
+#include "leds.h"
+
+// Idle manager. Once nothing has happened for idleAfterMs, loop() stops
+// spinning and the core waits in WFI for the next interrupt: a button edge,
+// a byte from the player UART or the USB serial port, an LED keyframe or the
+// idle tick that keeps the counters and the analytics flush going. Entering
+// idle puts a reader that stays powered into soft power-down and stops the
+// PWM slices of dark LEDs. Dormant mode would stop the clocks the UART and
+// USB need to receive, so the core only waits for interrupts; core 1 is not
+// started and already sleeps in the boot ROM.
+
+const unsigned long idleAfterMs = 2000;    // Quiet time before entering idle
+const uint32_t idleTickUs = 1000000;       // Longest single sleep
+const uint32_t idleWatchdogTimeout = 3000; // ms, longer than a tick
+
+// Current model for the estimate in STATS: RP2040 at 125 MHz plus the
+// board, with the core running and waiting in WFI
+const float activeMa = 25.0;
+const float sleepMa = 9.0;
+
+bool idleMode = false;
+unsigned long lastBusy = 0;     // millis() when work was last seen
+volatile alarm_id_t idleAlarm = 0; // Pending idle tick, 0 when none
+
+// Counters for STATS
+unsigned long idleEntries = 0;
+unsigned long idleSleeps = 0;   // WFI returns
+uint64_t idleUs = 0;            // Time spent in idle mode, awake or asleep
+uint64_t sleptUs = 0;           // Time spent in WFI
+uint32_t idleSinceUs = 0;
+uint32_t wokeUs = 0;            // micros() when the last WFI returned
+uint32_t lastWakeUs = 0;        // Wake to ready of the last exit from idle
+uint32_t maxWakeUs = 0;
+
+int64_t idleTick(alarm_id_t id, void *data)
+{
+  idleAlarm = 0;
+  return 0;
+}
+
+void enterIdle()
+{
+  idleMode = true;
+  idleEntries++;
+  idleSinceUs = micros();
+  sleepReader();
+  pauseLeds();
+  watchdogModeTimeout = idleWatchdogTimeout;
+  armWatchdog();
+}
+
+// Leave idle once work has shown up, the latency runs from the end of the
+// WFI that brought it
+void exitIdle()
+{
+  if (idleAlarm > 0)
+  {
+    cancel_alarm(idleAlarm);
+    idleAlarm = 0;
+  }
+  watchdogModeTimeout = watchdogTimeout;
+  armWatchdog();
+  resumeLeds();
+  wakeReader();
+  idleMode = false;
+
+  uint32_t now = micros();
+  idleUs += now - idleSinceUs;
+  lastWakeUs = now - wokeUs;
+  if (lastWakeUs > maxWakeUs)
+    maxWakeUs = lastWakeUs;
+}
+
+// Wait for the next interrupt. pending() is checked with interrupts off, so
+// an interrupt between that check and the WFI still ends the wait.
+void idleSleep(bool (*pending)())
+{
+  if (idleAlarm == 0)
+  {
+    alarm_id_t id = add_alarm_in_us(idleTickUs, idleTick, nullptr, true);
+    idleAlarm = id > 0 ? id : 0;
+  }
+
+  uint32_t status = save_and_disable_interrupts();
+  uint32_t start = micros();
+  if (!pending())
+    __wfi();
+  wokeUs = micros();
+  restore_interrupts(status); // The interrupt that woke the core runs here
+
+  sleptUs += wokeUs - start;
+  idleSleeps++;
+}
+
+void printIdleStats()
+{
+  uint64_t inIdle = idleUs + (idleMode ? micros() - idleSinceUs : 0);
+  uint64_t uptime = (uint64_t)millis() * 1000;
+  float asleep = uptime > 0 ? (float)sleptUs / uptime : 0;
+  float idleAsleep = inIdle > 0 ? (float)sleptUs / inIdle : 0;
+
+  Serial.print("Idle: ");
+  Serial.print(idleMode ? "now, " : "");
+  Serial.print(idleEntries);
+  Serial.print(" times, ");
+  Serial.print(idleSleeps);
+  Serial.print(" sleeps, asleep ");
+  Serial.print(asleep * 100, 1);
+  Serial.print("% of uptime, wake to ready last ");
+  Serial.print(lastWakeUs);
+  Serial.print(" us, max ");
+  Serial.print(maxWakeUs);
+  Serial.println(" us");
+  Serial.print("Idle current (estimate): ");
+  Serial.print(idleAsleep * sleepMa + (1 - idleAsleep) * activeMa, 1);
+  Serial.print(" mA idle, ");
+  Serial.print(asleep * sleepMa + (1 - asleep) * activeMa, 1);
+  Serial.println(" mA average");
+}
+
+#endif
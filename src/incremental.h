@@ -0,0 +1,136 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "rules.h"
+
+// Incremental evaluator: keeps the board and rule results of the previous
+// evaluation and only reruns the checks whose inputs changed since then.
+
+struct RuleCache
+{
+  int level;                       // Level of the cached results, -1 when empty
+  byte cards[numGatePins];         // presentCards at the last evaluation
+  byte totals[GROUP_COUNT];        // Group totals at the last evaluation
+  bool masked;                     // matchConnectionMasks() result
+  bool illegal;                    // hasIllegalComponents() result
+  bool known[maxRulesPerLevel];    // Rule result is valid for the cached board
+  bool results[maxRulesPerLevel];  // Rule results
+  Outcome outcome;                 // Cached verdict
+};
+
+RuleCache ruleCache = {-1, {}, {}, false, false, {}, {}, {}};
+
+// Counters for the DEBUG output
+unsigned long cachedVerdicts = 0; // Evaluations answered without running any check
+unsigned long rulesEvaluated = 0; // Rules run
+unsigned long rulesReused = 0;    // Rules answered from the cache
+
+// Inputs that changed since the cached evaluation, and update the cache
+uint16_t changedInputs(int level)
+{
+  uint16_t changed = 0;
+
+  for (int i = 0; i < numGatePins; i++)
+  {
+    if (presentCards[i] != ruleCache.cards[i])
+    {
+      changed |= IN_CARDS;
+      ruleCache.cards[i] = presentCards[i];
+    }
+  }
+
+  for (int g = 0; g < GROUP_COUNT; g++)
+  {
+    byte total = groupTotal(g);
+    if (total != ruleCache.totals[g])
+    {
+      changed |= 1 << g;
+      ruleCache.totals[g] = total;
+    }
+  }
+
+  if (level != ruleCache.level)
+  {
+    // Results of another level say nothing about this one
+    changed = 0xFFFF;
+    ruleCache.level = level;
+    for (int i = 0; i < maxRulesPerLevel; i++)
+    {
+      ruleCache.known[i] = false;
+    }
+  }
+
+  return changed;
+}
+
+// Same result as evaluateBoard(), reusing results of unaffected checks
+Outcome evaluateIncremental(int level)
+{
+  uint16_t changed = changedInputs(level);
+
+  if (changed == 0)
+  {
+    cachedVerdicts++;
+    return ruleCache.outcome;
+  }
+
+  if (changed & IN_CARDS)
+  {
+    ruleCache.masked = matchConnectionMasks();
+    ruleCache.illegal = level >= 0 && level < numLevels && hasIllegalComponents(level);
+  }
+
+  // Forget the results of rules that read a changed input
+  if (level >= 0 && level < numLevels)
+  {
+    for (int i = 0; i < maxRulesPerLevel; i++)
+    {
+      if (ruleReads(level, i) & changed)
+        ruleCache.known[i] = false;
+    }
+  }
+
+  int branch = BRANCH_FALLBACK;
+  if (!ruleCache.masked)
+  {
+    branch = BRANCH_MASK;
+  }
+  else if (level < 0 || level >= numLevels)
+  {
+    branch = BRANCH_INVALID_LEVEL;
+  }
+  else if (ruleCache.illegal)
+  {
+    branch = BRANCH_ILLEGAL;
+  }
+  else
+  {
+    for (int i = 0; i < maxRulesPerLevel; i++)
+    {
+      if (!ruleDefined(level, i))
+        continue;
+
+      if (ruleCache.known[i])
+      {
+        rulesReused++;
+      }
+      else
+      {
+        ruleCache.results[i] = runRule(level, i);
+        ruleCache.known[i] = true;
+        rulesEvaluated++;
+      }
+
+      if (ruleCache.results[i])
+      {
+        branch = BRANCH_RULE_0 + i;
+        break;
+      }
+    }
+  }
+
+  ruleCache.outcome = outcomeFromBranch(level, branch);
+  return ruleCache.outcome;
+}
+
+#endif
@@ -0,0 +1,231 @@
+#ifndef LEDS_H
+#define LEDS_H
+
+#include <math.h>
+#include <hardware/gpio.h>
+#include <hardware/pwm.h>
+#include <hardware/sync.h>
+#include <pico/time.h>
+#include "gates.h"
+
+// LED engine: every LED is a PWM channel with a brightness in a frame buffer,
+// written through a gamma table. Effects are described by a few keyframe
+// parameters and rendered from a hardware alarm, not from loop(). The alarm
+// sleeps until the next keyframe: a blink costs two renders per period, only
+// fades and pulses render at ledFrameUs, and nothing runs while every LED is
+// steady. An effect may start in the future, the cues start them relative to
+// the track they belong to.
+
+const int numLeds = 5;                       // LEDs per table
+const int numLedChannels = numTables * numLeds;
+const uint16_t ledWrap = 0xFFFF;             // PWM period in system clocks, about 1.9 kHz
+const float ledGammaExponent = 2.2;
+const uint32_t ledFrameUs = 10000;           // Render interval while a level is moving
+
+enum EffectKind
+{
+  EFFECT_NONE,  // Steady level
+  EFFECT_FADE,  // From the current level to level over the period
+  EFFECT_BLINK, // level for the first half of the period, off for the second
+  EFFECT_PULSE  // Up to level and back down over the period
+};
+
+struct LedEffect
+{
+  byte kind;
+  byte level;        // Peak or target brightness
+  uint16_t periodMs;
+  byte repeats;      // Periods to play, 0 plays until replaced
+  byte endLevel;     // Brightness after the last period
+};
+
+struct LedChannel
+{
+  int pin;
+  LedEffect effect;
+  uint32_t startUs; // Start of the first period, may lie ahead
+  byte from;        // Brightness when the effect was started
+};
+
+const LedEffect ledFadeOn = {EFFECT_FADE, 255, 150, 1, 255};
+
+LedChannel ledChannels[numLedChannels];
+volatile byte ledFrame[numLedChannels]; // Brightness of every LED, before gamma
+uint16_t ledGamma[256];
+alarm_id_t ledAlarm = 0; // Pending render, 0 when idle
+
+// Counters for STATS
+volatile unsigned long ledRenders = 0;
+volatile unsigned long ledWrites = 0;
+
+void writeLed(int c, byte level)
+{
+  if (ledFrame[c] == level)
+    return;
+  ledFrame[c] = level;
+  pwm_set_gpio_level(ledChannels[c].pin, ledGamma[level]);
+  ledWrites++;
+}
+
+// Brightness of a channel at now, wait is set to the time until it changes
+// next, 0 once the effect has ended
+byte effectLevel(const LedChannel &ch, uint32_t now, uint32_t &wait)
+{
+  const LedEffect &e = ch.effect;
+  if ((int32_t)(now - ch.startUs) < 0)
+  {
+    wait = ch.startUs - now;
+    return ledFrame[&ch - ledChannels];
+  }
+
+  uint32_t period = e.periodMs * 1000UL;
+  uint32_t elapsed = now - ch.startUs;
+  if (period == 0 || (e.repeats > 0 && elapsed / period >= e.repeats))
+  {
+    wait = 0;
+    return e.endLevel;
+  }
+
+  uint32_t phase = elapsed % period;
+  wait = ledFrameUs;
+  switch (e.kind)
+  {
+  case EFFECT_FADE:
+    return ch.from + ((int)e.level - ch.from) * (int32_t)(phase / 100) / (int32_t)(period / 100);
+
+  case EFFECT_BLINK:
+    wait = phase < period / 2 ? period / 2 - phase : period - phase;
+    return phase < period / 2 ? e.level : 0;
+
+  case EFFECT_PULSE:
+    phase = phase < period / 2 ? phase : period - phase;
+    return e.level * (phase / 100) / (period / 200);
+  }
+  wait = 0;
+  return e.endLevel;
+}
+
+// Write the frame of now, returns the time to the next keyframe, 0 when every
+// LED is steady
+uint32_t renderLeds(uint32_t now)
+{
+  uint32_t next = 0;
+  ledRenders++;
+  for (int c = 0; c < numLedChannels; c++)
+  {
+    LedChannel &ch = ledChannels[c];
+    if (ch.effect.kind == EFFECT_NONE)
+      continue;
+
+    uint32_t wait;
+    writeLed(c, effectLevel(ch, now, wait));
+    if (wait == 0)
+      ch.effect.kind = EFFECT_NONE;
+    else if (next == 0 || wait < next)
+      next = wait;
+  }
+  return next;
+}
+
+int64_t ledAlarmFired(alarm_id_t id, void *data)
+{
+  uint32_t next = renderLeds(micros());
+  if (next == 0)
+    ledAlarm = 0;
+  return next; // Rescheduled from the time this alarm was due, 0 stops it
+}
+
+// Render now and arm the alarm for the next keyframe, call with interrupts
+// disabled
+void rescheduleLeds()
+{
+  if (ledAlarm > 0)
+    cancel_alarm(ledAlarm);
+  uint32_t next = renderLeds(micros());
+  ledAlarm = next > 0 ? add_alarm_in_us(next, ledAlarmFired, nullptr, true) : 0;
+}
+
+// Set a steady brightness, replaces the effect of the channel
+void setLed(int c, byte level)
+{
+  uint32_t irq = save_and_disable_interrupts();
+  ledChannels[c].effect.kind = EFFECT_NONE;
+  writeLed(c, level);
+  restore_interrupts(irq);
+}
+
+// Play an effect on a channel from startUs on, which may lie ahead
+void startEffect(int c, const LedEffect &effect, uint32_t startUs)
+{
+  uint32_t irq = save_and_disable_interrupts();
+  LedChannel &ch = ledChannels[c];
+  ch.effect = effect;
+  ch.startUs = startUs;
+  ch.from = ledFrame[c];
+  rescheduleLeds();
+  restore_interrupts(irq);
+}
+
+// PWM for the LEDs of table t, all off
+void initLeds(int t, const int *pins)
+{
+  if (ledGamma[255] == 0)
+  {
+    for (int i = 0; i < 256; i++)
+    {
+      ledGamma[i] = powf(i / 255.0f, ledGammaExponent) * ledWrap + 0.5f;
+    }
+  }
+
+  for (int i = 0; i < numLeds; i++)
+  {
+    int c = t * numLeds + i;
+    int pin = pins[i];
+    ledChannels[c].pin = pin;
+    ledChannels[c].effect.kind = EFFECT_NONE;
+    ledFrame[c] = 0;
+
+    uint slice = pwm_gpio_to_slice_num(pin);
+    pwm_set_wrap(slice, ledWrap);
+    pwm_set_gpio_level(pin, 0);
+    pwm_set_enabled(slice, true);
+    gpio_set_function(pin, GPIO_FUNC_PWM);
+  }
+}
+
+// Stop the PWM slices whose LEDs are all dark and steady while the
+// controller idles, the PWM of lit LEDs keeps running without the CPU
+void pauseLeds()
+{
+  uint32_t busy = 0;
+  for (int c = 0; c < numLedChannels; c++)
+  {
+    if (ledFrame[c] != 0 || ledChannels[c].effect.kind != EFFECT_NONE)
+      busy |= 1UL << pwm_gpio_to_slice_num(ledChannels[c].pin);
+  }
+  for (int c = 0; c < numLedChannels; c++)
+  {
+    uint slice = pwm_gpio_to_slice_num(ledChannels[c].pin);
+    if (!((busy >> slice) & 1))
+      pwm_set_enabled(slice, false);
+  }
+}
+
+void resumeLeds()
+{
+  for (int c = 0; c < numLedChannels; c++)
+  {
+    pwm_set_enabled(pwm_gpio_to_slice_num(ledChannels[c].pin), true);
+  }
+}
+
+void printLedStats()
+{
+  Serial.print("LEDs: ");
+  Serial.print(ledRenders);
+  Serial.print(" renders, ");
+  Serial.print(ledWrites);
+  Serial.println(" PWM writes");
+}
+
+#endif
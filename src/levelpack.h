@@ -0,0 +1,171 @@
+#ifndef LEVELPACK_H
+#define LEVELPACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry.h"
+
+// Level pack: the allowed components, connection masks, rule chains and cue
+// tracks of every level as one binary image, shared with tools/level_pack.
+// The layout is fixed-size records in the target's native little-endian
+// form, so the firmware reads a pack in place from flash (see packstore.h)
+// without parsing or copying it. A rule is a list of group count tests that
+// must all, or for any rules one of them, hold; a rule without tests always
+// holds.
+//
+//   LevelPack header, 32 bytes
+//   PackLevel level[levels]
+//
+// The CRC-16 covers the whole pack with the crc field read as zero.
+
+const uint32_t packMagic = 0x504C564E; // "NVLP"
+const uint16_t packVersion = 1;
+const int packMaxRules = 4;  // Rules per level, rule 0 completes the level
+const int packMaxTerms = 7;  // Tests per rule
+const int packAdminErrors = 3;
+const int packCrcOffset = 12;
+
+enum PackOp
+{
+  OP_EQ,
+  OP_NE,
+  OP_LT,
+  OP_LE,
+  OP_GT,
+  OP_GE,
+  OP_COUNT
+};
+
+struct PackTerm
+{
+  byte group; // Group whose total is tested
+  byte op;    // PackOp
+  byte value;
+};
+
+struct PackRule
+{
+  byte track; // Track in folder 01 played when the rule decides
+  byte any;   // 1 when one test suffices, 0 when all must hold
+  byte terms;
+  PackTerm term[packMaxTerms];
+};
+
+struct PackLevel
+{
+  uint16_t allowed; // Bit c allows category c
+  byte rules;       // Rules in the chain
+  byte nextLevel;   // Level after completing this one, past the last level ends the game
+  byte followUpTrack;
+  byte restartTrack;                 // Admin restart
+  byte errorTracks[packAdminErrors]; // Admin errors 1 to 3, 0 for none
+  byte reserved;
+  PackRule rule[packMaxRules];
+};
+
+struct LevelPack
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;     // Bytes of the header and the levels
+  uint32_t revision; // Content revision, chosen by the author
+  uint16_t crc;
+  byte levels;
+  byte maskTrack;     // Occupied gates match no connection mask
+  byte illegalTrack;  // Component not allowed in the level
+  byte fallbackTrack; // No rule matched
+  byte reserved[6];
+  uint64_t masks;     // Bit m allows the occupied gates m, gate 1 is bit 0 of m
+};
+
+static_assert(sizeof(LevelPack) == 32 && offsetof(LevelPack, crc) == packCrcOffset, "Pack header layout");
+static_assert(sizeof(PackLevel) == 106, "Pack level layout");
+
+const PackLevel *packLevels(const LevelPack *pack)
+{
+  return (const PackLevel *)(pack + 1);
+}
+
+uint16_t packCrc(const byte *data, uint32_t size)
+{
+  uint16_t crc = 0xFFFF;
+  for (uint32_t i = 0; i < size; i++)
+  {
+    bool crcField = i == packCrcOffset || i == packCrcOffset + 1;
+    crc = crc16(crc, crcField ? 0 : data[i]);
+  }
+  return crc;
+}
+
+bool packTermHolds(const PackTerm &t, int total)
+{
+  switch (t.op)
+  {
+  case OP_EQ:
+    return total == t.value;
+  case OP_NE:
+    return total != t.value;
+  case OP_LT:
+    return total < t.value;
+  case OP_LE:
+    return total <= t.value;
+  case OP_GT:
+    return total > t.value;
+  case OP_GE:
+    return total >= t.value;
+  }
+  return false;
+}
+
+// Rule result for the group totals of a board
+bool packRuleHolds(const PackRule &r, const byte *totals)
+{
+  if (r.terms == 0)
+    return true;
+
+  for (int i = 0; i < r.terms; i++)
+  {
+    bool holds = packTermHolds(r.term[i], totals[r.term[i].group]);
+    if (holds == (r.any != 0))
+      return holds;
+  }
+  return r.any == 0;
+}
+
+// Reason the image is not a usable pack of levels levels and groups groups,
+// nullptr when it is
+const char *packProblem(const byte *data, uint32_t size, int levels, int groups)
+{
+  const LevelPack *pack = (const LevelPack *)data;
+  if (size < sizeof(LevelPack) || pack->magic != packMagic)
+    return "no level pack";
+  if (pack->version != packVersion)
+    return "unsupported version";
+  if (pack->levels != levels)
+    return "wrong number of levels";
+  if (pack->size != sizeof(LevelPack) + levels * sizeof(PackLevel) || pack->size > size)
+    return "wrong size";
+  if (pack->crc != packCrc(data, pack->size))
+    return "CRC mismatch";
+
+  for (int l = 0; l < levels; l++)
+  {
+    const PackLevel &lv = packLevels(pack)[l];
+    if (lv.rules > packMaxRules)
+      return "bad level record";
+    for (int r = 0; r < lv.rules; r++)
+    {
+      const PackRule &rule = lv.rule[r];
+      if (rule.terms > packMaxTerms)
+        return "too many tests in a rule";
+      for (int t = 0; t < rule.terms; t++)
+      {
+        if (rule.term[t].group >= groups || rule.term[t].op >= OP_COUNT)
+          return "bad rule test";
+      }
+    }
+  }
+  return nullptr;
+}
+
+#endif
@@ -2,35 +2,36 @@
 #include <SPI.h>
 #include <MFRC522.h>
 #include <MD_YX5300.h>
-#include <Bounce2.h>
-#include "UID.h"
-#include "lvl.h"
 
-bool DEBUG = true;
+bool DEBUG = true; // Also read by the headers below
 bool ADMIN = true;
 bool OVERRIDE = false;
-
-#define RST_PIN 21
-#define CS_PIN_2 2
+bool HINTS = true; // Follow an error cue with a hint towards the nearest solution
+
+#include "decision.h"
+#include "incremental.h"
+#include "hints.h"
+#include "recovery.h"
+#include "gates.h"
+#include "registry.h"
+#include "tagdata.h"
+#include "reader.h"
+#include "voting.h"
+#include "console.h"
+#include "buttons.h"
+#include "leds.h"
+#include "tables.h"
+#include "speculate.h"
+#include "feedback.h"
+#include "telemetry.h"
+#include "packstore.h"
+#include "analytics.h"
+#include "idle.h"
+#include "memory.h"
 
 #define BUTTON_PIN 10
-Bounce buttonDebouncer = Bounce(); // Create a Bounce object for the button
-
-const int gatePins[] = {22, 20, 17, 27, 28, 26};
-const int numGatePins = 6;
 
 const int ledPins[] = {11, 12, 13, 14, 15}; // Array for LED pins
-const int numLeds = 5;
-
-int currentLevel = 0; // Current level of the system
-
-MFRC522 rfid(CS_PIN_2, RST_PIN);
-SPISettings mfrc522SPISettings(50000, MSBFIRST, SPI_MODE0);
-
-bool isReaderInitialized = false;
-
-byte presentCards[numGatePins]; // Array to store the present card for each gate
-byte cardsCount[13];            // Array to store the count of cards for each category
 
 unsigned long lastScanTime = 0;           // Variable to track the last scan time
 const unsigned long scanInterval = 10000; // 5 seconds interval
@@ -38,234 +39,223 @@ const unsigned long scanInterval = 10000; // 5 seconds interval
 #define MP3Stream Serial2
 MD_YX5300 mp3(MP3Stream); // Create instance of MD_YX5300 class for MP3 player using MP3Stream
 
-bool introduction01 = true;
-bool introduction02 = false;
+// One entry per table, the gate pins of every table are listed in gates.h
+const TableHardware tableHardware[] = {
+    {BUTTON_PIN, ledPins, &mp3, 2000}};
+static_assert(sizeof(tableHardware) / sizeof(tableHardware[0]) == numTables, "Every table needs a button, LEDs and a player");
+
+// Boot stages, the player is brought up from loop() while the rest runs
+enum BootStage
+{
+  BOOT_READER, // Reset the reader while the player powers up
+  BOOT_PLAYER, // Wait for the player to answer a status query
+  BOOT_DEVICE, // Wait for the player to confirm the SD card selection
+  BOOT_READY   // Introduction started, button presses are handled
+};
+
+BootStage bootStage = BOOT_READER;
+unsigned long bootStageStart = 0;         // Start of the current boot stage
+unsigned long lastPlayerQuery = 0;        // Last status query sent to the players
+byte playersAnswered = 0;                 // Bit per table whose player answered in this stage
+const byte allPlayers = (1 << numTables) - 1;
+unsigned long bootReadyTime = 0;          // Time to first interaction in milliseconds
+const unsigned long playerTimeout = 1500; // Proceed without a reply after this time
+const unsigned long deviceTimeout = 500;
+const unsigned long queryInterval = 100; // Repeat unanswered status queries
 
 void setup()
 {
+  paintStack(); // Before anything else runs deep
   Serial.begin(9600); // Initialize Serial Monitor
   SPI.begin();
 
+  // Initialize all gate pins as outputs and close all gates
+  initGates();
+
+  // Initialize the LEDs (off) and the button of every table
+  for (int t = 0; t < numTables; t++)
+  {
+    initTable(t, tableHardware[t]);
+  }
+
+  pinMode(CS_PIN_2, OUTPUT);
+  pinMode(RST_PIN, OUTPUT);
+
   // Initialize MP3Stream
   MP3Stream.setRX(9); // Ensure these match your hardware setup
   MP3Stream.setTX(8);
   MP3Stream.begin(MD_YX5300::SERIAL_BPS);
 
-  // Initialize MP3 player
+  // Start the MP3 player, loop() waits for it to answer instead of a fixed delay
   mp3.begin();
-  delay(1000);      // Allow time for initialization
-  mp3.device(0x02); // Select SD card as storage device
-  delay(500);
 
-  // Initialize all gate pins as outputs and set them LOW (closed gate)
-  for (int i = 0; i < numGatePins; i++)
+  // After a watchdog reset the players are still running, resume the level
+  // every table was in. An introduction that was cut short plays its track
+  // again from the start, pollIntroduction() takes over at its end.
+  if (recoverFromWatchdog())
   {
-    pinMode(gatePins[i], OUTPUT);
-    digitalWrite(gatePins[i], LOW);
+    Serial.print("Boot: recovered level");
+    for (int t = 0; t < numTables && t < stashedTables; t++)
+    {
+      Table &s = tables[t];
+      restoreGameState(t, s.level, s.intro01, s.intro02);
+      if (s.intro01 || s.intro02)
+        s.hw.player->playSpecific(1, s.intro01 ? 1 : 3);
+      Serial.print(" ");
+      Serial.print(s.level);
+    }
+    bootReadyTime = millis();
+    bootStage = BOOT_READY;
+    sendBoot(bootReadyTime, watchdogResets, numTables);
+    Serial.print(" after a watchdog reset in ");
+    Serial.print(bootReadyTime);
+    Serial.println(" ms.");
+    printRecoveryStats();
   }
+  loadTable(0);
 
-  // Initialize all LED pins as outputs and set them LOW (off)
-  for (int i = 0; i < numLeds; i++)
+  // Levels from the pack in flash when one was uploaded
+  if (loadLevelPack() == nullptr)
   {
-    pinMode(ledPins[i], OUTPUT);
-    digitalWrite(ledPins[i], LOW);
+    printPackStatus();
   }
 
-  pinMode(CS_PIN_2, OUTPUT);
-  pinMode(RST_PIN, OUTPUT);
+  // Use the generated decision table only when it matches the rules
+  if (!checkDecisionTable())
+  {
+    Serial.println("Decision table is out of date, evaluating the rules incrementally instead.");
+  }
+  if (!checkHints())
+  {
+    Serial.println("Hints are disabled, the winning boards are out of date.");
+  }
 
-  // Play the first file (001 in the main folder)
-  Serial.println("Playing file 001 in the main folder...");
-  mp3.playSpecific(1, 1); // File index 001 corresponds to 1
-  introduction01 = true;
+  // Continue the session log after the newest record in flash
+  initAnalytics();
 
-  // Initialize the button pin
-  pinMode(BUTTON_PIN, INPUT_PULLUP);
-  buttonDebouncer.attach(BUTTON_PIN);
-  buttonDebouncer.interval(25); // Debounce interval in milliseconds
+  bootStageStart = millis();
+  armWatchdog();
 }
 
-void initializeReader()
-{
-  digitalWrite(CS_PIN_2, LOW);
-  delay(20);
-  digitalWrite(RST_PIN, HIGH);
-  delay(20); // Wait for the reader to reset
-  digitalWrite(RST_PIN, LOW);
-  delay(20); // Wait for the reader to stabilize
-  SPI.beginTransaction(mfrc522SPISettings);
-  rfid.PCD_Init();
-  delay(20);
-  SPI.endTransaction();
-  delay(20);
-  digitalWrite(CS_PIN_2, HIGH);
+int reportedLevels[numTables]; // Levels last sent as telemetry
 
-  if (DEBUG)
+void saveGameState()
+{
+  storeTable(activeTable);
+  for (int t = 0; t < numTables; t++)
   {
-    Serial.print("Firmware version: ");
-    rfid.PCD_DumpVersionToSerial();
+    if (t < stashedTables)
+      stashGameState(t, tables[t].level, tables[t].intro01, tables[t].intro02);
+
+    if (tables[t].level != reportedLevels[t])
+    {
+      sendLevel(t, reportedLevels[t], tables[t].level);
+      reportedLevels[t] = tables[t].level;
+    }
   }
-  isReaderInitialized = true;
 }
 
-void flickerLED(int ledIndex, int times = 3, int duration = 500, bool leaveOn = true)
+const unsigned long countersInterval = 10000; // Send the error counters
+unsigned long lastCounters = 0;
+
+void sendCounters()
 {
-  for (int i = 0; i < times; i++)
+  unsigned long misses = 0;
+  for (int t = 0; t < numTables; t++)
   {
-    digitalWrite(ledPins[ledIndex], HIGH);
-    delay(duration);
-    digitalWrite(ledPins[ledIndex], LOW);
-    delay(duration);
+    misses += tables[t].budgetMisses;
   }
 
-  if (leaveOn)
-  {
-    digitalWrite(ledPins[ledIndex], HIGH);
-  }
+  byte payload[14];
+  byte *p = put32(payload, millis() / 1000);
+  p = put16(p, audioTimeouts);
+  p = put16(p, audioErrors);
+  p = put16(p, recoveredGates);
+  p = put16(p, misses);
+  put16(p, droppedFrames);
+  sendTelemetry(EV_COUNTERS, payload, sizeof(payload));
 }
 
-void checkReader(int gateIndex)
+// Hand queued telemetry to the USB serial port without blocking. A frame is only
+// started when all of it fits, so DEBUG text never lands inside one.
+void drainTelemetry()
 {
-  byte scannedUID[7] = {0}; // Array to store the scanned UID
-  bool uidFound = false;    // Flag to indicate if a UID was found
-  const int maxAttempts = 3;
-
-  initializeReader(); // Ensure the reader is properly reset
-  delay(50);          // Give time to stabilize
-
-  for (int attempt = 0; attempt < maxAttempts; attempt++)
+  while (telemetryQueued() > 0)
   {
-    digitalWrite(CS_PIN_2, LOW);
-    SPI.beginTransaction(mfrc522SPISettings);
-
-    byte bufferATQA[2];
-    byte bufferSize = sizeof(bufferATQA);
-
-    if (rfid.PICC_WakeupA(bufferATQA, &bufferSize) == MFRC522::STATUS_OK)
+    int room = Serial.availableForWrite();
+    if (telemetryFrameLeft == 0)
     {
-      if (rfid.PICC_Select(&rfid.uid) == MFRC522::STATUS_OK)
-      {
-        if (DEBUG)
-        {
-          Serial.print("Card UID at Gate ");
-          Serial.print(gateIndex + 1);
-          Serial.print(": ");
-        }
-
-        // Copy the UID into the scannedUID array
-        for (byte i = 0; i < rfid.uid.size; i++)
-        {
-          scannedUID[i] = rfid.uid.uidByte[i];
-        }
-
-        // Print the UID to Serial
-        if (DEBUG)
-        {
-          Serial.print("UID: ");
-          for (byte i = 0; i < rfid.uid.size; i++)
-          {
-            Serial.print(scannedUID[i], HEX);
-            if (i < rfid.uid.size - 1)
-            {
-              Serial.print(":");
-            }
-          }
-          Serial.println();
-        }
-
-        uidFound = true;
-        rfid.PICC_HaltA();
-        rfid.PCD_StopCrypto1();
-        break; // UID found, break out of retry loop
-      }
+      int frameSize = telemetryHeader + telemetryRing[(telemetryTail + 3) & (telemetryRingSize - 1)] + telemetryTrailer;
+      if (room < frameSize)
+        return;
+      telemetryFrameLeft = frameSize;
     }
+    if (room <= 0)
+      return;
 
-    SPI.endTransaction();
-    digitalWrite(CS_PIN_2, HIGH);
-    delay(20); // Wait a bit before retrying
+    // Rest of the frame, up to the end of the ring
+    int chunk = min((int)telemetryFrameLeft, telemetryRingSize - telemetryTail);
+    if (chunk > room)
+      chunk = room;
+    int written = Serial.write(telemetryRing + telemetryTail, chunk);
+    telemetryTail = (telemetryTail + written) & (telemetryRingSize - 1);
+    telemetryFrameLeft -= written;
+    if (written < chunk)
+      return;
   }
+}
 
-  if (uidFound)
-  {
-    // Compare the scanned UID with the registered list
-    for (int i = 0; i < registeredCount; i++)
-    {
-      bool match = true;
-      for (int j = 0; j < 7; j++)
-      {
-        if (scannedUID[j] != registered[i].uid[j])
-        {
-          match = false;
-          break;
-        }
-      }
+// Read a single gate again, used by confirmBoard()
+byte readGate(int gate)
+{
+  openGate(tableGate(gate));
+  settleGate(tableGate(gate));
+  checkReader(gate);
+  closeGates();
+  return presentCards[gate];
+}
 
-      if (match)
-      {
-        presentCards[gateIndex] = registered[i].category; // Update the array with the category
-        if (DEBUG)
-        {
-          Serial.print("Gate ");
-          Serial.print(gateIndex + 1);
-          Serial.print(": Category ");
-          Serial.println(registered[i].category);
-        }
-        return; // Exit the function once a match is found
-      }
-    }
+// Read one gate of the active table
+void scanGate(int gate)
+{
+  setActivity(ACTIVITY_SCAN);
+  openGate(tableGate(gate)); // Closes the other gates first
+  settleGate(tableGate(gate));
 
-    // If no match is found
-    presentCards[gateIndex] = 0; // Set to 0 to indicate no match
-    if (DEBUG)
-    {
-      Serial.print("Gate ");
-      Serial.print(gateIndex + 1);
-      Serial.println(": No matching category found.");
-    }
-  }
-  else
+  if (DEBUG)
   {
-    presentCards[gateIndex] = 0; // Set to 0 if no UID was found
-    if (DEBUG)
-    {
-      Serial.print("Gate ");
-      Serial.print(gateIndex + 1);
-      Serial.println(": No card detected.");
-    }
+    Serial.print("Activating gate ");
+    Serial.print(gatePins[tableGate(gate)]);
+    Serial.println(".");
   }
+
+  checkReader(gate); // Check the reader for the current gate
 }
 
-void scanCards()
+// Close the gates after a sweep and confirm the board
+void finishScan()
 {
-  // Close all gates
-  for (int i = 0; i < numGatePins; i++)
-  {
-    digitalWrite(gatePins[i], LOW);
-  }
-  delay(20);
+  setActivity(ACTIVITY_SCAN);
+  closeGates();
 
+  // Read doubtful empty gates again before the board is evaluated
+  confirmBoard(readGate);
   if (DEBUG)
   {
-    Serial.println("All gates are closed.");
+    printVotingStats();
   }
 
-  // Iterate through each gate and check for cards
+  byte recovered = 0;
   for (int i = 0; i < numGatePins; i++)
   {
-    digitalWrite(gatePins[i], HIGH); // Open the current gate
-    delay(20);
-
-    if (DEBUG)
-    {
-      Serial.print("Activating gate ");
-      Serial.print(gatePins[i]);
-      Serial.println(".");
-    }
-
-    checkReader(i);
-    delay(20);                      // Check the reader for the current gate
-    digitalWrite(gatePins[i], LOW); // Close the current gate
+    if (gateDecision[i] == GATE_RECOVERED)
+      recovered |= 1 << i;
   }
+  sendScan(activeTable, currentLevel, presentCards, numGatePins, recovered,
+           scanTransactions[activeTable], scanBytes[activeTable], scanLibraryGates[activeTable]);
+  scanTransactions[activeTable] = 0;
+  scanBytes[activeTable] = 0;
+  scanLibraryGates[activeTable] = 0;
 
   if (DEBUG)
   {
@@ -278,252 +268,127 @@ void scanCards()
       Serial.println(presentCards[i]);
     }
   }
-
-  for (int i = 0; i < 13; i++)
-  {
-    cardsCount[i] = 0;
-  }
-
-  // Count the number of cards in each category
-  for (int i = 0; i < numGatePins; i++)
-  {
-    int val = presentCards[i];
-    if (val >= 1 && val <= 13)
-    {
-      cardsCount[val - 1]++;
-    }
-  }
 }
 
-bool hasIllegalComponents(int level)
+// Read every gate of the active table in one go
+void scanCards()
 {
-  const int *allowed = allowedComponents[level];
-  int count = allowedComponentsCount[level];
-
   for (int i = 0; i < numGatePins; i++)
   {
-    int val = presentCards[i];
-    if (val == 0)
-      continue;
-
-    bool isAllowed = false;
-    for (int j = 0; j < count; j++)
-    {
-      if (val == allowed[j])
-      {
-        isAllowed = true;
-        break;
-      }
-    }
-
-    if (!isAllowed)
-      return true;
+    scanGate(i);
   }
-
-  return false;
+  finishScan();
 }
 
-bool matchConnectionMasks()
+// Queue the completion sequence of a level and move on to the next one
+void completeLevel(int level)
 {
-  for (int i = 0; i < connectionMasksCount; i++)
+  currentLevel = levelNext(level);
+  queueCue(CUE_PLAY, 1 << 8 | ruleTrack(level, 0));
+  if (level == 0)
   {
-    bool match = true;
-    for (int j = 0; j < numGatePins; j++)
-    {
-      if (connectionMasks[i][j] == 0 && presentCards[j] != 0)
-      {
-        match = false;
-        break;
-      }
-      else if (connectionMasks[i][j] == 1 && presentCards[j] == 0)
-      {
-        match = false;
-        break;
-      }
-    }
-    if (match)
+    // Chase from 5 s into the track, then flash all LEDs three times
+    for (int i = 0; i < numLeds; i++)
     {
-      return true;
+      queueEffect(i, ledFadeOn, 5000 + i * 500);
     }
+    queueFlicker(allLeds, 3, 500, false, 7500);
   }
-  return false;
-}
-
-// LEVEL 1
-bool lvl1_0()
-{
-  // 1 weerstand en 1 led
-  int totalLEDs = cardsCount[3] + cardsCount[4] + cardsCount[5];
-  int totalResistors = cardsCount[10] + cardsCount[11];
-
-  return (totalLEDs == 1 && totalResistors == 1);
-}
-
-bool lvl1_1()
-{
-  // geen led aanwezig
-  int totalLEDs = cardsCount[3] + cardsCount[4] + cardsCount[5];
-
-  return (totalLEDs == 0);
-}
-
-bool lvl1_2()
-{
-  // geen weerstand aanwezig
-  int totalResistors = cardsCount[10] + cardsCount[11];
-
-  return (totalResistors == 0);
-}
-
-// LEVEL 2
-bool lvl2_0()
-{
-  // één SW, één led, en één weerstand
-  int totalSW = cardsCount[6] + cardsCount[7]; // Normale switches
-  int totalLEDs = cardsCount[3] + cardsCount[4] + cardsCount[5];
-  int totalResistors = cardsCount[10] + cardsCount[11];
-
-  return (totalSW == 1 && totalLEDs == 1 && totalResistors == 1);
-}
-
-bool lvl2_1()
-{
-  // Nieuwe conditie: geen weerstand
-  int totalResistors = cardsCount[10] + cardsCount[11];
-
-  return (totalResistors == 0);
-}
-
-bool lvl2_2()
-{
-  // (was lvl2_1) één LED, één weerstand, en geen SW
-  int totalSW = cardsCount[6] + cardsCount[7]; // Normale switches
-  int totalLEDs = cardsCount[3] + cardsCount[4] + cardsCount[5];
-  int totalResistors = cardsCount[10] + cardsCount[11];
-
-  return (totalSW == 0 && totalLEDs == 1 && totalResistors == 1);
-}
-
-bool lvl2_3()
-{
-  // (was lvl2_2) één SW, en geen LED
-  int totalSW = cardsCount[6] + cardsCount[7]; // Normale switches
-  int totalLEDs = cardsCount[3] + cardsCount[4] + cardsCount[5];
-
-  return (totalSW == 1 && totalLEDs == 0);
-}
-
-// LEVEL 3
-bool lvl3_0()
-{
-  // één PushSW, één led, en één weerstand
-  int totalPushSW = cardsCount[8] + cardsCount[9]; // Push switches
-  int totalLEDs = cardsCount[3] + cardsCount[4] + cardsCount[5];
-  int totalResistors = cardsCount[10] + cardsCount[11];
-
-  return (totalPushSW == 1 && totalLEDs == 1 && totalResistors == 1);
-}
-
-bool lvl3_1()
-{
-  // Nieuwe conditie: geen weerstand
-  int totalResistors = cardsCount[10] + cardsCount[11];
-
-  return (totalResistors == 0);
-}
-
-bool lvl3_2()
-{
-  // (was lvl3_1) één SW, één led, en één weerstand
-  int totalSW = cardsCount[6] + cardsCount[7]; // Normale switches
-  int totalLEDs = cardsCount[3] + cardsCount[4] + cardsCount[5];
-  int totalResistors = cardsCount[10] + cardsCount[11];
-
-  return (totalSW == 1 && totalLEDs == 1 && totalResistors == 1);
-}
-
-bool lvl3_3()
-{
-  // (was lvl3_2) geen PushSW
-  int totalPushSW = cardsCount[8] + cardsCount[9]; // Push switches
-
-  return (totalPushSW == 0);
+  else
+  {
+    queueFlicker(level - 1, 3, 500, true);
+  }
+  queueCue(CUE_WAIT_END);
+  if (level < numLevels - 1)
+  {
+    queueCue(CUE_PAUSE, 1000); // Wait for 1 second before proceeding
+  }
+  queueTrack(levelFollowUp(level));
 }
 
-// LEVEL 4
-bool lvl4_0()
+void playAdminTrack(byte track)
 {
-  // 2 weerstanden en 2 LED
-  int totalLEDs = cardsCount[3] + cardsCount[4] + cardsCount[5];
-  int totalResistors = cardsCount[10] + cardsCount[11];
-
-  return (totalLEDs == 2 && totalResistors == 2);
+  if (track == 0)
+    return;
+  queueTrack(track);
 }
 
-bool lvl4_1()
+void adminReset()
 {
-  // Nieuwe conditie: geen weerstand
-  int totalResistors = cardsCount[10] + cardsCount[11];
-
-  return (totalResistors == 0);
+  // Full reset
+  currentLevel = 0;
+  queueCue(CUE_LED_OFF, allLeds);
+  queueCue(CUE_PLAY, 1 << 8 | 1); // File index 001 corresponds to 1
+  introduction01 = true;
+  if (DEBUG)
+    Serial.println("Admin: Full reset performed.");
 }
 
-bool lvl4_2()
+void adminPreviousLevel()
 {
-  // (was lvl4_1) 1 weerstand en 2 LED
-  int totalLEDs = cardsCount[3] + cardsCount[4] + cardsCount[5];
-  int totalResistors = cardsCount[10] + cardsCount[11];
-
-  return (totalLEDs == 2 && totalResistors == 1);
+  // Go to the previous level
+  if (currentLevel > 0)
+    currentLevel--;
+  if (DEBUG)
+    Serial.println("Admin: Moved to previous level.");
 }
 
-bool lvl4_3()
+void adminApprove()
 {
-  // (was lvl4_2) 1 LED
-  int totalLEDs = cardsCount[3] + cardsCount[4] + cardsCount[5];
-
-  return (totalLEDs == 1);
+  // Level approved
+  if (DEBUG)
+    Serial.println("Admin: Level approved.");
+  if (currentLevel >= 0 && currentLevel < numLevels)
+  {
+    completeLevel(currentLevel);
+  }
 }
 
-// LEVEL 5
-bool lvl5_0()
+void adminError(int error)
 {
-  // 1 fotodiode, 1 weerstand, een PushSW, een LED en een T-junction
-  int totalPhotodiodes = cardsCount[12]; // Fotodiode is op index 12
-  int totalResistors = cardsCount[10] + cardsCount[11];
-  int totalPushSW = cardsCount[8] + cardsCount[9]; // Push switches
-  int totalLEDs = cardsCount[3] + cardsCount[4] + cardsCount[5];
-  int totalTJunctions = cardsCount[2]; // T-junctions op index 2
-
-  return (totalPhotodiodes == 1 && totalResistors == 1 && totalPushSW == 1 && totalLEDs == 1 && totalTJunctions == 1);
+  // Error 1 to 3 of the current level
+  if (error < 1 || error > 3)
+    return;
+  if (currentLevel >= 0 && currentLevel < numLevels)
+  {
+    playAdminTrack(errorTrack(currentLevel, error));
+  }
+  if (DEBUG)
+  {
+    Serial.print("Admin: Error ");
+    Serial.print(error);
+    Serial.println(" executed.");
+  }
 }
 
-bool lvl5_1()
+void adminFallback()
 {
-  // Nieuwe conditie: geen weerstand
-  int totalResistors = cardsCount[10] + cardsCount[11];
-
-  return (totalResistors == 0);
+  // Fallback
+  playAdminTrack(outcomeFromBranch(currentLevel, BRANCH_FALLBACK).track);
+  if (DEBUG)
+    Serial.println("Admin: Fallback executed.");
 }
 
-bool lvl5_2()
+void adminRestartLevel()
 {
-  // (was lvl5_1) geen fotodiode en/of geen PushSW
-  int totalPhotodiodes = cardsCount[12];           // Fotodiode is op index 12
-  int totalPushSW = cardsCount[8] + cardsCount[9]; // Push switches
-
-  return (totalPhotodiodes == 0 || totalPushSW == 0);
+  // Restart current level
+  if (currentLevel >= 0 && currentLevel < numLevels)
+  {
+    playAdminTrack(restartTrack(currentLevel));
+  }
+  if (DEBUG)
+    Serial.println("Admin: Restarted current level.");
 }
 
-bool lvl5_3()
+void adminToggleDebug()
 {
-  // (was lvl5_2) geen weerstand en/of geen t-junction
-  int totalResistors = cardsCount[10] + cardsCount[11];
-  int totalTJunctions = cardsCount[2]; // T-junctions op index 2
-
-  return (totalResistors == 0 || totalTJunctions == 0);
+  // Toggle debug
+  DEBUG = !DEBUG;
+  Serial.print("Admin: Debug mode is now ");
+  Serial.println(DEBUG ? "on" : "off");
 }
 
+// Admin keys placed on the board, the serial console offers the same actions
 void handleAdminCommands()
 {
   if (!ADMIN)
@@ -535,238 +400,47 @@ void handleAdminCommands()
     switch (presentCards[i])
     {
     case ADMIN_KEY_A:
-      // Full reset
-      currentLevel = 0;
-      for (int i = 0; i < numLeds; i++)
-      {
-        digitalWrite(ledPins[i], LOW);
-      }
-      mp3.playSpecific(1, 1); // File index 001 corresponds to 1
-      introduction01 = true;
-      if (DEBUG)
-        Serial.println("Admin: Full reset performed.");
+      adminReset();
       OVERRIDE = true;
       break;
 
     case ADMIN_KEY_B:
-      // Go to the previous level
-      if (currentLevel > 0)
-        currentLevel--;
-      if (DEBUG)
-        Serial.println("Admin: Moved to previous level.");
+      adminPreviousLevel();
       OVERRIDE = true;
       break;
 
     case ADMIN_KEY_C:
-      // Level approved
-      if (DEBUG)
-        Serial.println("Admin: Level approved.");
-      if (currentLevel == 0)
-      {
-        currentLevel = 1;
-        mp3.playSpecific(1, 4);
-        delay(5000);
-        for (int i = 0; i < 5; i++)
-        {
-          digitalWrite(ledPins[i], HIGH);
-          delay(500);
-        }
-        for (int i = 0; i < 3; i++)
-        {
-          for (int j = 0; j < numLeds; j++)
-          {
-            digitalWrite(ledPins[j], HIGH);
-          }
-          delay(500);
-          for (int j = 0; j < numLeds; j++)
-          {
-            digitalWrite(ledPins[j], LOW);
-          }
-          delay(500);
-        }
-        while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-        {
-        }
-        delay(1000); // Wait for 1 second before proceeding
-        mp3.playSpecific(1, 6);
-        while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-        {
-        }
-      }
-      else if (currentLevel == 1)
-      {
-        currentLevel = 2;
-        mp3.playSpecific(1, 7);
-        flickerLED(0, 3, 500, true);
-        while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-        {
-        }
-        delay(1000); // Wait for 1 second before proceeding
-        mp3.playSpecific(1, 10);
-        while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-        {
-        }
-      }
-      else if (currentLevel == 2)
-      {
-        currentLevel = 3;
-        mp3.playSpecific(1, 11);
-        flickerLED(1, 3, 500, true);
-        while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-        {
-        }
-        delay(1000); // Wait for 1 second before proceeding
-        mp3.playSpecific(1, 14);
-        while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-        {
-        }
-      }
-      else if (currentLevel == 3)
-      {
-        currentLevel = 4;
-        mp3.playSpecific(1, 15);
-        flickerLED(2, 3, 500, true);
-        while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-        {
-        }
-        delay(1000); // Wait for 1 second before proceeding
-        mp3.playSpecific(1, 18);
-        while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-        {
-        }
-      }
-      else if (currentLevel == 4)
-      {
-        currentLevel = 5;
-        mp3.playSpecific(1, 19);
-        flickerLED(3, 3, 500, true);
-        while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-        {
-        }
-        delay(1000); // Wait for 1 second before proceeding
-        mp3.playSpecific(1, 22);
-        while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-        {
-        }
-      }
-      else if (currentLevel == 5)
-      {
-        currentLevel = 10;
-        mp3.playSpecific(1, 23);
-        flickerLED(4, 3, 500, true);
-        while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-        {
-        }
-        mp3.playSpecific(1, 26);
-        while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-        {
-        }
-      }
+      adminApprove();
       OVERRIDE = true;
       break;
 
     case ADMIN_KEY_D:
-      // Error 1
-      if (currentLevel == 0)
-        mp3.playSpecific(1, 5);
-      if (currentLevel == 1)
-        mp3.playSpecific(1, 8);
-      if (currentLevel == 2)
-        mp3.playSpecific(1, 9);
-      if (currentLevel == 3)
-        mp3.playSpecific(1, 9);
-      if (currentLevel == 4)
-        mp3.playSpecific(1, 9);
-      if (currentLevel == 5)
-        mp3.playSpecific(1, 9);
-
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      if (DEBUG)
-        Serial.println("Admin: Error 1 executed.");
+      adminError(1);
       OVERRIDE = true;
       break;
 
     case ADMIN_KEY_E:
-      // Error 2
-      if (currentLevel == 1)
-        mp3.playSpecific(1, 9);
-      if (currentLevel == 2)
-        mp3.playSpecific(1, 12);
-      if (currentLevel == 3)
-        mp3.playSpecific(1, 16);
-      if (currentLevel == 4)
-        mp3.playSpecific(1, 20);
-      if (currentLevel == 5)
-        mp3.playSpecific(1, 24);
-
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      if (DEBUG)
-        Serial.println("Admin: Error 2 executed.");
+      adminError(2);
       OVERRIDE = true;
       break;
 
     case ADMIN_KEY_F:
-      // Error 3
-      if (currentLevel == 2)
-        mp3.playSpecific(1, 13);
-      if (currentLevel == 3)
-        mp3.playSpecific(1, 17);
-      if (currentLevel == 4)
-        mp3.playSpecific(1, 21);
-      if (currentLevel == 5)
-        mp3.playSpecific(1, 25);
-
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      if (DEBUG)
-        Serial.println("Admin: Error 3 executed.");
+      adminError(3);
       OVERRIDE = true;
       break;
 
     case ADMIN_KEY_G:
-      // Fallback
-      mp3.playSpecific(1, 2);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      if (DEBUG)
-        Serial.println("Admin: Fallback executed.");
+      adminFallback();
       OVERRIDE = true;
       break;
 
     case ADMIN_KEY_H:
-      // Restart current level
-      if (currentLevel == 0)
-        mp3.playSpecific(1, 3);
-      if (currentLevel == 1)
-        mp3.playSpecific(1, 6);
-      if (currentLevel == 2)
-        mp3.playSpecific(1, 10);
-      if (currentLevel == 3)
-        mp3.playSpecific(1, 14);
-      if (currentLevel == 4)
-        mp3.playSpecific(1, 18);
-      if (currentLevel == 5)
-        mp3.playSpecific(1, 22);
-
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      if (DEBUG)
-        Serial.println("Admin: Restarted current level.");
+      adminRestartLevel();
       OVERRIDE = true;
       break;
 
     case ADMIN_KEY_J:
-      // Toggle debug
-      DEBUG = !DEBUG;
-      Serial.print("Admin: Debug mode is now ");
-      Serial.println(DEBUG ? "on" : "off");
+      adminToggleDebug();
       OVERRIDE = true;
       break;
 
@@ -777,17 +451,20 @@ void handleAdminCommands()
   }
 }
 
+// Start a sweep of the active table after its button was pressed
 void buttonPressed()
 {
 
   if (DEBUG)
   {
-    Serial.println("Button pressed.");
+    Serial.print("Button pressed at table ");
+    Serial.print(activeTable + 1);
+    Serial.println(".");
     Serial.print("Current level: ");
     Serial.println(currentLevel);
   }
   // Calculate the timestamp in hh:mm:ss format
-  unsigned long currentMillis = millis();
+  unsigned long currentMillis = table->pressedAt;
   unsigned long seconds = currentMillis / 1000;
   unsigned long minutes = seconds / 60;
   unsigned long hours = minutes / 60;
@@ -809,12 +486,35 @@ void buttonPressed()
     Serial.print("0");
   Serial.println(seconds);
 
-  scanCards(); // Scan cards when the button is pressed
   if (DEBUG)
   {
     Serial.println("Button pressed, scanning cards.");
   }
+  table->presses++;
+  table->nextGate = 0;
+  table->phase = TABLE_SCAN;
+  feedbackStart();
+}
+
+// Tell the player which tile to change first: action and gate, then the
+// component to place
+void queueHint(const Hint &hint)
+{
+  if (hint.action == HINT_NONE)
+    return;
 
+  hintsGiven++;
+  sendHint(activeTable, currentLevel, hint.distance, hint.action, hint.gate, hint.group);
+  queueTrack((hint.action - HINT_ADD) * 10 + hint.gate + 1, hintFolder);
+  if (hint.action == HINT_ADD || hint.action == HINT_SWAP)
+  {
+    queueTrack(hint.group + 1, hintGroupFolder);
+  }
+}
+
+// Evaluate the scanned board of the active table and queue the cues
+void evaluatePress()
+{
   // print the scanned cards to Serial
   Serial.print("Scanned cards: {");
   for (int i = 0; i < numGatePins; i++)
@@ -832,382 +532,772 @@ void buttonPressed()
   if (OVERRIDE)
     return; // Skip if OVERRIDE is active
 
-  if (!matchConnectionMasks())
+  Outcome outcome;
+  if (speculationHolds())
+    outcome = table->specOutcome;
+  else
+    outcome = decisionTableValid ? lookupOutcome(currentLevel) : evaluateIncremental(currentLevel);
+  sendVerdict(activeTable, currentLevel, outcome.branch, outcome.track);
+  recordSession(activeTable, currentLevel, outcome, table->pressedAt);
+
+  if (DEBUG && !decisionTableValid)
   {
-    mp3.playSpecific(1, 5);
-    while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-    {
-    }
+    Serial.print("Rules evaluated: ");
+    Serial.print(rulesEvaluated);
+    Serial.print(", reused: ");
+    Serial.print(rulesReused);
+    Serial.print(", cached verdicts: ");
+    Serial.println(cachedVerdicts);
+  }
+
+  if (outcome.branch == BRANCH_RULE_0)
+  {
+    completeLevel(currentLevel);
     return;
   }
 
-  if (currentLevel == 0)
+  if (outcome.branch == BRANCH_INVALID_LEVEL)
   {
-    if (hasIllegalComponents(0))
-    {
-      mp3.playSpecific(1, 2);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
-    else
+    currentLevel = outcome.nextLevel;
+    if (DEBUG)
     {
-      currentLevel = 1;
-      mp3.playSpecific(1, 4);
-      delay(5000);
-      for (int i = 0; i < 5; i++)
-      {
-        digitalWrite(ledPins[i], HIGH);
-        delay(500);
-      }
-      for (int i = 0; i < 3; i++)
-      {
-        for (int j = 0; j < numLeds; j++)
-        {
-          digitalWrite(ledPins[j], HIGH);
-        }
-        delay(500);
-        for (int j = 0; j < numLeds; j++)
-        {
-          digitalWrite(ledPins[j], LOW);
-        }
-        delay(500);
-      }
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      delay(1000); // Wait for 1 second before proceeding
-      mp3.playSpecific(1, 6);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      Serial.println("Invalid level, moving to level 10.");
     }
+    return;
   }
-  else if (currentLevel == 1)
+
+  queueTrack(outcome.track);
+
+  if (HINTS)
   {
-    if (hasIllegalComponents(1))
-    {
-      mp3.playSpecific(1, 2);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
-    else if (lvl1_0())
-    {
-      currentLevel = 2;
-      mp3.playSpecific(1, 7);
-      flickerLED(0, 3, 500, true);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      delay(1000); // Wait for 1 second before proceeding
-      mp3.playSpecific(1, 10);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
-    else if (lvl1_1())
-    {
-      mp3.playSpecific(1, 8);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
-    else if (lvl1_2())
-    {
-      mp3.playSpecific(1, 9);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
+    Hint hint = findHint(currentLevel);
+    if (DEBUG)
+      printHint(hint);
+    queueHint(hint);
+  }
+}
+
+// Write a category to the tile on a gate and verify it
+bool provisionGate(int gate, byte category)
+{
+  bool written = false;
+
+  openGate(tableGate(gate));
+  settleGate(tableGate(gate));
+  initializeReader();
+  waitMs(50);
+
+  digitalWrite(CS_PIN_2, LOW);
+  SPI.beginTransaction(mfrc522SPISettings);
+
+  byte bufferATQA[2];
+  byte bufferSize = sizeof(bufferATQA);
+  if (rfid.PICC_WakeupA(bufferATQA, &bufferSize) == MFRC522::STATUS_OK &&
+      rfid.PICC_Select(&rfid.uid) == MFRC522::STATUS_OK)
+  {
+    written = writeTagCategory(rfid, category);
+    rfid.PICC_HaltA();
+  }
+
+  SPI.endTransaction();
+  digitalWrite(CS_PIN_2, HIGH);
+  closeGates();
+  return written;
+}
+
+// PROVISION c1 c2 c3 c4 c5 c6: write a category to the tile on every gate,
+// 0 skips a gate. Place a tile set on the board and repeat per set.
+void provisionTiles(char *args)
+{
+  int provisioned = 0;
+  int failed = 0;
+
+  for (int gate = 0; gate < numGatePins; gate++)
+  {
+    char *token = strtok(gate == 0 ? args : nullptr, " ");
+    if (token == nullptr)
+      break;
+
+    int category = atoi(token);
+    if (category <= 0 || category > 255)
+      continue;
+
+    bool written = provisionGate(gate, category);
+    Serial.print("Gate ");
+    Serial.print(gate + 1);
+    Serial.print(": category ");
+    Serial.print(category);
+    Serial.println(written ? " written and verified." : " FAILED.");
+    if (written)
+      provisioned++;
     else
+      failed++;
+  }
+
+  Serial.print("Provisioned ");
+  Serial.print(provisioned);
+  Serial.print(" tiles, ");
+  Serial.print(failed);
+  Serial.println(" failed.");
+}
+
+void printBoard()
+{
+  Serial.print("Board: {");
+  for (int i = 0; i < numGatePins; i++)
+  {
+    Serial.print(presentCards[i]);
+    if (i < numGatePins - 1)
     {
-      mp3.playSpecific(1, 2);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      Serial.print(", ");
     }
   }
-  else if (currentLevel == 2)
+  Serial.println("}");
+}
+
+// Commands that change the board or the level of the console's table are
+// refused while a press is in progress, its cues would play for another state
+bool consoleTableIdle(const char *command)
+{
+  if (table->phase == TABLE_IDLE && table->cueCount == 0)
+    return true;
+  Serial.print(command);
+  Serial.print(" refused, table ");
+  Serial.print(activeTable + 1);
+  Serial.println(" is handling a press. Try again once it is idle.");
+  return false;
+}
+
+void cmdLevel(char *args)
+{
+  int level = atoi(args);
+  if (*args == '\0' || ((level < 0 || level >= numLevels) && level != 10))
+  {
+    Serial.println("Usage: LEVEL 0-5 or LEVEL 10");
+    return;
+  }
+  if (!consoleTableIdle("LEVEL"))
+    return;
+  currentLevel = level;
+  Serial.print("Level set to ");
+  Serial.println(currentLevel);
+}
+
+void cmdApprove(char *args)
+{
+  adminApprove();
+}
+
+void cmdBack(char *args)
+{
+  adminPreviousLevel();
+}
+
+void cmdReset(char *args)
+{
+  adminReset();
+}
+
+void cmdError(char *args)
+{
+  adminError(atoi(args));
+}
+
+void cmdFallback(char *args)
+{
+  adminFallback();
+}
+
+void cmdReplay(char *args)
+{
+  adminRestartLevel();
+}
+
+void cmdCue(char *args)
+{
+  char *folder = strtok(args, " ");
+  char *track = strtok(nullptr, " ");
+  if (folder == nullptr || track == nullptr)
   {
-    if (hasIllegalComponents(2))
+    Serial.println("Usage: CUE folder track");
+    return;
+  }
+  queueCue(CUE_PLAY, atoi(folder) << 8 | atoi(track));
+}
+
+void cmdLog(char *args)
+{
+  if (strcasecmp(args, "on") == 0)
+    DEBUG = true;
+  else if (strcasecmp(args, "off") == 0)
+    DEBUG = false;
+  Serial.print("Debug mode is ");
+  Serial.println(DEBUG ? "on" : "off");
+}
+
+int consoleTable = 0; // Table the console commands act on
+
+void cmdTable(char *args)
+{
+  int t = atoi(args);
+  if (t < 1 || t > numTables)
+  {
+    Serial.print("Usage: TABLE 1-");
+    Serial.println(numTables);
+    return;
+  }
+  consoleTable = t - 1;
+  Serial.print("Console acts on table ");
+  Serial.println(t);
+}
+
+void cmdTelemetry(char *args)
+{
+  if (strcasecmp(args, "on") == 0)
+    TELEMETRY = true;
+  else if (strcasecmp(args, "off") == 0)
+    TELEMETRY = false;
+  Serial.print("Telemetry is ");
+  Serial.println(TELEMETRY ? "on" : "off");
+}
+
+void cmdFeedback(char *args)
+{
+  if (strcasecmp(args, "on") == 0)
+    FEEDBACK = true;
+  else if (strcasecmp(args, "off") == 0)
+    FEEDBACK = false;
+  Serial.print("Scan feedback is ");
+  Serial.println(FEEDBACK ? "on" : "off");
+}
+
+void cmdState(char *args)
+{
+  Serial.print("Table ");
+  Serial.print(activeTable + 1);
+  Serial.print(", level: ");
+  Serial.print(currentLevel);
+  Serial.print(", introduction: ");
+  Serial.print(introduction01);
+  Serial.print(" ");
+  Serial.println(introduction02);
+  printBoard();
+  Serial.print("Board state: 0x");
+  Serial.print((unsigned long)(boardState >> 32), HEX);
+  Serial.print(" ");
+  Serial.println((unsigned long)boardState, HEX);
+}
+
+void cmdStats(char *args)
+{
+  Serial.print("Boot: ready after ");
+  Serial.print(bootReadyTime);
+  Serial.print(" ms, uptime ");
+  Serial.print(millis() / 1000);
+  Serial.println(" s");
+  printRecoveryStats();
+  printVotingStats();
+  printGateTiming();
+  printReaderStats();
+  Serial.print("Decision table: ");
+  Serial.println(decisionTableValid ? "in use" : "out of date");
+  Serial.print("Rules evaluated: ");
+  Serial.print(rulesEvaluated);
+  Serial.print(", reused: ");
+  Serial.print(rulesReused);
+  Serial.print(", cached verdicts: ");
+  Serial.println(cachedVerdicts);
+  printTableStats();
+  printButtonStats();
+  printLedStats();
+  printPackStatus();
+  printAnalyticsStats();
+  printSpeculationStats();
+  printFeedbackStats();
+  printIdleStats();
+  printMemoryStats();
+  Serial.print("Hints: ");
+  Serial.print(hintsValid ? "given " : "disabled, given ");
+  Serial.print(hintsGiven);
+  Serial.print(", last search ");
+  Serial.print(lastHintUs);
+  Serial.println(" us");
+}
+
+void cmdHint(char *args)
+{
+  printHint(findHint(currentLevel));
+}
+
+void cmdExport(char *args)
+{
+  if (!exportSessions(Serial))
+  {
+    Serial.println();
+    Serial.println("Export stopped, the host did not read it.");
+  }
+}
+
+// Every histogram at every level through the pack rules, far longer than
+// the watchdog timeout on the M0+
+const uint32_t levelCheckWatchdogTimeout = 2000;
+
+// Check the decision table and the hints against the levels in use again
+// and forget the cached verdicts, after the levels changed
+void levelsChanged()
+{
+  storeTable(activeTable);
+  watchdog_enable(levelCheckWatchdogTimeout, true);
+  bool tableValid = checkDecisionTable();
+  bool hintsMatch = checkHints();
+  armWatchdog();
+  if (!tableValid)
+  {
+    Serial.println("Decision table does not match the levels, evaluating the rules incrementally instead.");
+  }
+  if (!hintsMatch)
+  {
+    Serial.println("Hints are disabled, the winning boards do not match the levels.");
+  }
+  for (int t = 0; t < numTables; t++)
+  {
+    tables[t].cache.level = -1;
+  }
+  loadTable(activeTable);
+}
+
+void packReceived(bool complete)
+{
+  if (!complete)
+  {
+    Serial.println("Pack upload incomplete, nothing stored.");
+    return;
+  }
+
+  const char *problem = storeLevelPack(packUpload, packUploadSize);
+  if (problem != nullptr)
+  {
+    Serial.print("Pack rejected: ");
+    Serial.println(problem);
+  }
+  levelsChanged();
+  printPackStatus();
+}
+
+void cmdPack(char *args)
+{
+  if (*args == '\0')
+  {
+    printPackStatus();
+    return;
+  }
+
+  if (strcasecmp(args, "BUILTIN") == 0)
+  {
+    storeLevelPack(nullptr, 0);
+    levelsChanged();
+    printPackStatus();
+    return;
+  }
+
+  long size = atol(args);
+  if (size <= 0 || size > (long)packAreaSize)
+  {
+    Serial.println("Usage: PACK bytes, followed by the pack, or PACK BUILTIN");
+    return;
+  }
+  packUploadSize = size;
+  receiveConsoleBytes(packUpload, size, packReceived);
+}
+
+void cmdMem(char *args)
+{
+  if (strncasecmp(args, "ALARM", 5) == 0)
+  {
+    int percent = atoi(args + 5);
+    if (percent < 1 || percent > 100)
     {
-      mp3.playSpecific(1, 2);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
+      Serial.println("Usage: MEM ALARM percent, 1 to 100");
       return;
     }
-    else if (lvl2_0())
+    memoryAlarmPercent = percent;
+    memoryAlarmed = false;
+    checkMemory();
+  }
+  printMemoryStats();
+}
+
+void cmdScan(char *args)
+{
+  if (!consoleTableIdle("SCAN"))
+    return;
+  scanCards();
+  printBoard();
+}
+
+void cmdCalibrate(char *args)
+{
+  calibrateGates(rfid);
+  printGateTiming();
+}
+
+const ConsoleCommand consoleCommands[] = {
+    {"TABLE", cmdTable, "n: act on table n"},
+    {"LEVEL", cmdLevel, "n: jump to level n"},
+    {"APPROVE", cmdApprove, ": approve the current level"},
+    {"BACK", cmdBack, ": go to the previous level"},
+    {"RESET", cmdReset, ": full reset, replays the introduction"},
+    {"ERROR", cmdError, "1-3: play an error cue of the current level"},
+    {"FALLBACK", cmdFallback, ": play the fallback cue"},
+    {"REPLAY", cmdReplay, ": replay the instructions of the current level"},
+    {"CUE", cmdCue, "folder track: play any track"},
+    {"LOG", cmdLog, "on|off: debug output"},
+    {"TELEMETRY", cmdTelemetry, "on|off: binary telemetry frames"},
+    {"FEEDBACK", cmdFeedback, "on|off: LEDs and acknowledgement while a press is scanned"},
+    {"STATE", cmdState, ": level, introduction flags and board"},
+    {"STATS", cmdStats, ": boot, recovery, confirmation, rule and table counters"},
+    {"HINT", cmdHint, ": nearest solution for the board of the last scan"},
+    {"EXPORT", cmdExport, ": send the session log as one binary block"},
+    {"PACK", cmdPack, "n|builtin: receive a level pack of n bytes, or go back to the built-in levels"},
+    {"MEM", cmdMem, "[alarm percent]: flash, RAM, heap and stack use, optionally set the alarm level"},
+    {"SCAN", cmdScan, ": read all gates without evaluating"},
+    {"CALIBRATE", cmdCalibrate, ": measure the gate settle times"},
+    {"PROVISION", provisionTiles, "c1 .. c6: write categories to the tiles on the gates"}};
+
+const int consoleCommandCount = sizeof(consoleCommands) / sizeof(consoleCommands[0]);
+
+void setBootStage(BootStage stage)
+{
+  bootStage = stage;
+  bootStageStart = millis();
+  lastPlayerQuery = bootStageStart;
+  playersAnswered = 0;
+}
+
+// Collect the answers of the players, returns true once all of them answered
+bool pollPlayers(bool statusOnly)
+{
+  for (int t = 0; t < numTables; t++)
+  {
+    MD_YX5300 &player = *tables[t].hw.player;
+    if (player.check() && (!statusOnly || player.getStatus()->code == MD_YX5300::STS_STATUS))
     {
-      currentLevel = 3;
-      mp3.playSpecific(1, 11);
-      flickerLED(1, 3, 500, true);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      delay(1000); // Wait for 1 second before proceeding
-      mp3.playSpecific(1, 14);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      playersAnswered |= 1 << t;
     }
-    else if (lvl2_1())
+  }
+  return playersAnswered == allPlayers;
+}
+
+// Query the players that did not answer yet
+void queryPlayers()
+{
+  for (int t = 0; t < numTables; t++)
+  {
+    if (!(playersAnswered & (1 << t)))
+      tables[t].hw.player->queryStatus();
+  }
+  lastPlayerQuery = millis();
+}
+
+// Advance the boot sequence, returns once the current stage is waiting
+void bootStep()
+{
+  switch (bootStage)
+  {
+  case BOOT_READER:
+    initializeReader();
+    if (calibrateOnBoot)
     {
-      mp3.playSpecific(1, 9);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      calibrateGates(rfid);
+      if (DEBUG)
+        printGateTiming();
     }
-    else if (lvl2_2())
+    setBootStage(BOOT_PLAYER);
+    queryPlayers();
+    break;
+
+  case BOOT_PLAYER:
+  {
+    bool playersReplied = pollPlayers(false);
+    if (playersReplied || millis() - bootStageStart >= playerTimeout)
     {
-      mp3.playSpecific(1, 12);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
+      if (!playersReplied && DEBUG)
+        Serial.println("Boot: no reply from every MP3 player, continuing.");
+      setBootStage(BOOT_DEVICE);
+      for (int t = 0; t < numTables; t++)
       {
+        tables[t].hw.player->device(0x02); // Select SD card as storage device
       }
-      return;
+      queryPlayers();
     }
-    else if (lvl2_3())
+    else if (millis() - lastPlayerQuery >= queryInterval)
     {
-      mp3.playSpecific(1, 13);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      queryPlayers();
     }
-    else
+    break;
+  }
+
+  case BOOT_DEVICE:
+    if (pollPlayers(true) || millis() - bootStageStart >= deviceTimeout)
     {
-      mp3.playSpecific(1, 2);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
+      // Play the first file (001 in the main folder)
+      Serial.println("Playing file 001 in the main folder...");
+      for (int t = 0; t < numTables; t++)
       {
+        selectTable(t);
+        table->hw.player->playSpecific(1, 1); // File index 001 corresponds to 1
+        introduction01 = true;
       }
-      return;
+
+      bootReadyTime = millis();
+      setBootStage(BOOT_READY);
+      sendBoot(bootReadyTime, watchdogResets, numTables);
+      Serial.print("Boot: ready for interaction after ");
+      Serial.print(bootReadyTime);
+      Serial.println(" ms.");
     }
+    break;
+
+  case BOOT_READY:
+    break;
   }
-  else if (currentLevel == 3)
+}
+
+// Move from the first introduction to the instructions of challenge 0
+void pollIntroduction()
+{
+  // Check if the MP3 player has finished playing the current track
+  if (table->hw.player->check())
   {
-    if (hasIllegalComponents(3))
-    {
-      mp3.playSpecific(1, 2);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
-    else if (lvl3_0())
-    {
-      currentLevel = 4;
-      mp3.playSpecific(1, 15);
-      flickerLED(2, 3, 500, true);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      delay(1000); // Wait for 1 second before proceeding
-      mp3.playSpecific(1, 18);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
-    else if (lvl3_1())
-    {
-      mp3.playSpecific(1, 9);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
-    else if (lvl3_2())
+    const MD_YX5300::cbData *status = table->hw.player->getStatus();
+
+    if (status->code == MD_YX5300::STS_FILE_END)
     {
-      mp3.playSpecific(1, 16);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
+      if (introduction01)
       {
+        if (DEBUG)
+        {
+          Serial.println("Finished the introduction, moving towards challenge 0");
+        }
+        queueCue(CUE_PAUSE, 500);
+        queueCue(CUE_PLAY, 1 << 8 | 3);
+        introduction01 = false;
+        introduction02 = true;
       }
-      return;
-    }
-    else if (lvl3_3())
-    {
-      mp3.playSpecific(1, 17);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
+      else if (introduction02)
       {
+        introduction02 = false;
+        watchBoard(*table);
       }
-      return;
     }
-    else
+  }
+}
+
+// Latch the presses queued by the button interrupts for idle tables, a press
+// during a cue is ignored. The press keeps the time of its first edge.
+void pollButtons()
+{
+  ButtonEvent event;
+  while (nextButtonEvent(event))
+  {
+    Table &s = tables[event.button];
+    if (event.pressed && s.phase == TABLE_IDLE && !s.pressPending)
     {
-      mp3.playSpecific(1, 2);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      s.pressPending = true;
+      s.pressedUs = event.timeUs;
+      s.pressedAt = millis() - (micros() - event.timeUs) / 1000;
     }
   }
-  else if (currentLevel == 4)
+}
+
+// Tables between a press and its verdict need the shared reader
+bool needsReader(const Table &s)
+{
+  return s.phase == TABLE_SCAN || s.phase == TABLE_CONFIRM || s.phase == TABLE_EVALUATE;
+}
+
+// One bounded piece of work for the active table
+void stepTable()
+{
+  unsigned long start = micros();
+
+  switch (table->phase)
   {
-    if (hasIllegalComponents(4))
+  case TABLE_IDLE:
+    pollIntroduction();
+    if (table->cueCount > 0)
     {
-      mp3.playSpecific(1, 2);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      table->phase = TABLE_CUE; // Cues queued by the introduction or the console
     }
-    else if (lvl4_0())
+    else if (table->pressPending)
     {
-      currentLevel = 5;
-      mp3.playSpecific(1, 19);
-      flickerLED(3, 3, 500, true);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      delay(1000); // Wait for 1 second before proceeding
-      mp3.playSpecific(1, 22);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      table->pressPending = false;
+      buttonPressed();
     }
-    else if (lvl4_1())
+    else if (!introduction01 && !introduction02)
     {
-      mp3.playSpecific(1, 9);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      stepArm(*table);
     }
-    else if (lvl4_2())
+    break;
+
+  case TABLE_SCAN:
+    if (table->nextGate == 0)
+      table->stageUs = 0;
+    scanGate(table->nextGate);
+    feedbackGate(table->nextGate, presentCards[table->nextGate]);
+    table->nextGate++;
+    table->stageUs += micros() - start;
+    if (table->nextGate >= numGatePins)
     {
-      mp3.playSpecific(1, 20);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      sendTiming(activeTable, STAGE_SCAN, table->stageUs);
+      table->phase = TABLE_CONFIRM;
     }
-    else if (lvl4_3())
+    break;
+
+  case TABLE_CONFIRM:
+    finishScan();
+    for (int i = 0; i < numGatePins; i++)
     {
-      mp3.playSpecific(1, 21);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      if (gateDecision[i] == GATE_RECOVERED)
+        feedbackGate(i, presentCards[i]);
     }
-    else
+    sendTiming(activeTable, STAGE_CONFIRM, micros() - start);
+    table->phase = TABLE_EVALUATE;
+    break;
+
+  case TABLE_EVALUATE:
+    evaluatePress();
+    feedbackDone();
+    sendTiming(activeTable, STAGE_EVALUATE, micros() - start);
+    sendTiming(activeTable, STAGE_LATENCY, recordLatency());
+    table->phase = TABLE_CUE;
+    break;
+
+  case TABLE_CUE:
+    if (runCues(*table))
     {
-      mp3.playSpecific(1, 2);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      table->phase = TABLE_IDLE;
+      watchBoard(*table);
     }
+    break;
   }
-  else if (currentLevel == 5)
+
+  unsigned long slice = micros() - start;
+  if (slice > table->maxSliceUs)
+    table->maxSliceUs = slice;
+}
+
+// Every table gets its cheap work (button, introduction, cues) on every
+// pass. The reader is shared, so only one table reads per pass: the one whose
+// latency budget runs out first, or a watched board when no press waits.
+void serveTables()
+{
+  pollButtons();
+
+  int reader = -1;
+  for (int t = 0; t < numTables; t++)
   {
-    if (hasIllegalComponents(5))
-    {
-      mp3.playSpecific(1, 2);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
-    else if (lvl5_0())
-    {
-      currentLevel = 10;
-      mp3.playSpecific(1, 23);
-      flickerLED(4, 3, 500, true);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      mp3.playSpecific(1, 26);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
-    else if (lvl5_1())
-    {
-      mp3.playSpecific(1, 9);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
-    else if (lvl5_2())
-    {
-      mp3.playSpecific(1, 24);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
-    else if (lvl5_3())
-    {
-      mp3.playSpecific(1, 25);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
-    }
-    else
+    if (needsReader(tables[t]))
     {
-      mp3.playSpecific(1, 2);
-      while (!mp3.check() || mp3.getStatus()->code != MD_YX5300::STS_FILE_END)
-      {
-      }
-      return;
+      unsigned long deadline = tables[t].pressedAt + tables[t].hw.latencyBudget;
+      if (reader < 0 || (long)(deadline - (tables[reader].pressedAt + tables[reader].hw.latencyBudget)) < 0)
+        reader = t;
+      continue;
     }
+    selectTable(t);
+    stepTable();
+    feedWatchdog();
+  }
+
+  if (reader >= 0)
+  {
+    selectTable(reader);
+    stepTable();
   }
   else
   {
-    currentLevel = 10;
-    if (DEBUG)
-    {
-      Serial.println("Invalid level, moving to level 10.");
-    }
+    speculate(); // The reader is free, read a watched board ahead of its press
+  }
+}
+
+// Input that has arrived but not been handled, also checked with interrupts off
+bool inputPending()
+{
+  return buttonHead != buttonTail || Serial.available() > 0 || MP3Stream.available() > 0;
+}
+
+// Work in progress keeps the controller out of idle
+bool controllerBusy()
+{
+  if (consoleBytes != nullptr || consoleLength > 0)
+    return true;
+  for (int t = 0; t < numTables; t++)
+  {
+    const Table &s = tables[t];
+    if (s.phase != TABLE_IDLE || s.pressPending || s.cueCount > 0 || watchingBoard(s))
+      return true;
+  }
+  return false;
+}
+
+// Sleep between interactions, see idle.h
+void manageIdle()
+{
+  if (controllerBusy() || inputPending())
+  {
+    lastBusy = millis();
+    if (idleMode)
+      exitIdle();
+    return;
+  }
+  if (telemetryQueued() > 0)
+    return;
+
+  if (!idleMode)
+  {
+    if (millis() - lastBusy < idleAfterMs)
+      return;
+    enterIdle();
   }
+  idleSleep(inputPending);
 }
 
 void loop()
 {
-  // Check if the MP3 player has finished playing the current track
-  if (mp3.check())
+  feedWatchdog();
+  saveGameState();
+  drainTelemetry();
+
+  if (bootStage != BOOT_READY)
   {
-    const MD_YX5300::cbData *status = mp3.getStatus();
+    bootStep();
+    return;
+  }
 
-    if (status->code == MD_YX5300::STS_FILE_END)
-    {
-      if (introduction01)
-      {
-        if (DEBUG)
-        {
-          Serial.println("Finished the introduction, moving towards challenge 0");
-        }
-        delay(500);
-        mp3.playSpecific(1, 3);
-        introduction01 = false;
-        introduction02 = true;
-      }
-      else if (introduction02)
-      {
-        introduction02 = false;
-      }
-    }
+  setActivity(ACTIVITY_IDLE);
+  if (millis() - lastCounters >= countersInterval)
+  {
+    sendCounters();
+    checkMemory();
+    lastCounters = millis();
   }
+  drainTelemetry();
+
+  selectTable(consoleTable);
+  pollConsole(consoleCommands, consoleCommandCount);
 
-  buttonDebouncer.update(); // Update the button state
+  serveTables();
 
-  // Check if the button was pressed
-  if (buttonDebouncer.fell())
+  // Flash work only while no press is waiting for its verdict
+  bool pressInFlight = false;
+  for (int t = 0; t < numTables; t++)
   {
-    buttonPressed();
+    pressInFlight |= tables[t].pressPending || needsReader(tables[t]);
   }
+  if (!pressInFlight)
+  {
+    flushAnalytics();
+  }
+
+  manageIdle();
 }
@@ -0,0 +1,119 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <hardware/flash.h>
+
+// Memory headroom at runtime. Core 0 runs setup(), loop() and every
+// interrupt handler on one stack; setup() paints its free part and the high
+// water mark is the deepest word no longer holding the paint. Core 1 is never
+// started, so it has no stack to watch. Flash and static RAM come from the
+// linker symbols; tools/mem_report breaks them down by subsystem at build time.
+
+// Linker symbols of the core's memory map
+extern uint32_t __StackBottom;   // Lowest word of the core 0 stack
+extern uint32_t __StackTop;      // End of the core 0 stack, also the end of RAM
+extern uint8_t __flash_binary_start;
+extern uint8_t __flash_binary_end;
+extern uint8_t __data_start__;
+extern uint8_t __bss_end__;
+extern uint8_t _FS_start;
+
+const uint32_t stackPaint = 0x5AC3A55A;
+const uint32_t ramStart = 0x20000000;
+
+int memoryAlarmPercent = 80;  // Alarm when the stack or the heap is used beyond this
+bool memoryAlarmed = false;   // Alarm given, until the usage drops again
+unsigned long memoryAlarms = 0;
+
+// Fill the stack of core 0 below the caller with the paint, first thing in setup()
+void paintStack()
+{
+  volatile uint32_t here;
+  uint32_t *end = (uint32_t *)&here - 64; // Keep clear of this frame
+  for (uint32_t *p = &__StackBottom; p < end; p++)
+  {
+    *p = stackPaint;
+  }
+}
+
+uint32_t stackSize()
+{
+  return (uint32_t)((uint8_t *)&__StackTop - (uint8_t *)&__StackBottom);
+}
+
+// Deepest stack use of core 0 since boot in bytes, stackSize() when the
+// paint at the bottom is gone
+uint32_t stackHighWater()
+{
+  const uint32_t *p = &__StackBottom;
+  while (p < &__StackTop && *p == stackPaint)
+  {
+    p++;
+  }
+  return (uint32_t)((const uint8_t *)&__StackTop - (const uint8_t *)p);
+}
+
+int usedPercent(uint32_t used, uint32_t size)
+{
+  return size > 0 ? (int)((uint64_t)used * 100 / size) : 0;
+}
+
+// Check the stack and the heap against memoryAlarmPercent, prints once per excursion
+void checkMemory()
+{
+  int stack = usedPercent(stackHighWater(), stackSize());
+  int heap = usedPercent(rp2040.getUsedHeap(), rp2040.getTotalHeap());
+  bool over = stack >= memoryAlarmPercent || heap >= memoryAlarmPercent;
+
+  if (over && !memoryAlarmed)
+  {
+    memoryAlarms++;
+    Serial.print("Memory alarm: stack ");
+    Serial.print(stack);
+    Serial.print("%, heap ");
+    Serial.print(heap);
+    Serial.print("% used, limit ");
+    Serial.print(memoryAlarmPercent);
+    Serial.println("%");
+  }
+  memoryAlarmed = over;
+}
+
+void printMemoryStats()
+{
+  uint32_t image = &__flash_binary_end - &__flash_binary_start;
+  uint32_t program = (uint32_t)(uintptr_t)&_FS_start - XIP_BASE; // Flash in front of the filesystem
+  uint32_t ram = (uint32_t)(uintptr_t)&__StackTop - ramStart;
+  uint32_t statics = &__bss_end__ - &__data_start__;
+
+  Serial.print("Flash: ");
+  Serial.print(image);
+  Serial.print(" of ");
+  Serial.print(program);
+  Serial.print(" bytes (");
+  Serial.print(usedPercent(image, program));
+  Serial.println("%)");
+  Serial.print("RAM: ");
+  Serial.print(statics);
+  Serial.print(" of ");
+  Serial.print(ram);
+  Serial.print(" bytes static, heap ");
+  Serial.print(rp2040.getUsedHeap());
+  Serial.print(" used, ");
+  Serial.print(rp2040.getFreeHeap());
+  Serial.print(" free of ");
+  Serial.println(rp2040.getTotalHeap());
+  Serial.print("Stack core 0: ");
+  Serial.print(stackHighWater());
+  Serial.print(" of ");
+  Serial.print(stackSize());
+  Serial.print(" bytes at most (");
+  Serial.print(usedPercent(stackHighWater(), stackSize()));
+  Serial.println("%), core 1 not started");
+  Serial.print("Memory alarm at ");
+  Serial.print(memoryAlarmPercent);
+  Serial.print("%, raised ");
+  Serial.println(memoryAlarms);
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef PACKSTORE_H
+#define PACKSTORE_H
+
+#include <string.h>
+#include <hardware/flash.h>
+#include <hardware/sync.h>
+#include "recovery.h"
+#include "rules.h"
+
+// Level pack storage: the first sector of the filesystem area
+// (board_build.filesystem_size) holds the pack, the session log in
+// analytics.h uses the rest. The pack is checked once at boot and then read
+// in place through XIP. PACK on the console uploads a new pack, which is
+// checked in RAM before the sector is rewritten, so a bad upload leaves the
+// stored pack alone.
+
+// Filesystem area reserved by the core, see platformio.ini
+extern uint8_t _FS_start;
+extern uint8_t _FS_end;
+
+const uint32_t packAreaSize = FLASH_SECTOR_SIZE;
+const uint32_t packWriteWatchdogTimeout = 1000; // Erase and program of one sector
+const size_t packAlign = 8; // The M0+ faults on unaligned halfword and word loads
+
+// Packs are read in place through LevelPack and PackLevel pointers
+static_assert(alignof(LevelPack) <= packAlign && alignof(PackLevel) <= packAlign &&
+              sizeof(LevelPack) % alignof(PackLevel) == 0, "Pack buffers are not aligned enough");
+
+alignas(packAlign) byte packUpload[packAreaSize]; // Upload being received
+uint32_t packUploadSize = 0;
+
+uint32_t packOffset()
+{
+  return (uint32_t)(uintptr_t)(&_FS_start) - XIP_BASE;
+}
+
+// Use the pack in flash when it is valid, returns the reason when it is not
+const char *loadLevelPack()
+{
+  const char *problem = levelPackProblem(&_FS_start, packAreaSize);
+  levelPack = problem == nullptr ? (const LevelPack *)&_FS_start : nullptr;
+  return problem;
+}
+
+// Rewrite the pack sector with size bytes of data, 0 leaves it erased and
+// returns to the built-in levels
+const char *storeLevelPack(const byte *data, uint32_t size)
+{
+  if (size > 0)
+  {
+    const char *problem = levelPackProblem(data, size);
+    if (problem != nullptr)
+      return problem;
+  }
+
+  // Whole pages, the rest of the last page stays erased
+  alignas(packAlign) static byte pages[packAreaSize];
+  uint32_t length = (size + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE * FLASH_PAGE_SIZE;
+  memset(pages, 0xFF, length);
+  if (size > 0)
+    memcpy(pages, data, size);
+
+  levelPack = nullptr;
+  watchdog_enable(packWriteWatchdogTimeout, true);
+  uint32_t ints = save_and_disable_interrupts();
+  flash_range_erase(packOffset(), FLASH_SECTOR_SIZE);
+  if (length > 0)
+    flash_range_program(packOffset(), pages, length);
+  restore_interrupts(ints);
+  armWatchdog();
+
+  return size > 0 ? loadLevelPack() : nullptr;
+}
+
+void printPackStatus()
+{
+  Serial.print("Levels: ");
+  if (levelPack == nullptr)
+  {
+    Serial.println("built in");
+    return;
+  }
+  Serial.print("pack revision ");
+  Serial.print(levelPack->revision);
+  Serial.print(", ");
+  Serial.print(levelPack->size);
+  Serial.println(" bytes in flash");
+}
+
+#endif
@@ -0,0 +1,584 @@
+#ifndef READER_H
+#define READER_H
+
+#include <SPI.h>
+#include <MFRC522.h>
+#include "gates.h"
+#include "recovery.h"
+#include "registry.h"
+#include "rules.h"
+#include "tagdata.h"
+
+// Lean reader path for what a gate read needs: wake the tile, select it,
+// fetch the UID and the category page. Registers are accessed over SPI
+// directly, one chip select per access: the status registers are read in one
+// burst, the FIFO is filled and emptied in one burst, the CRC_A is computed
+// here instead of by the reader, and configuration writes that would not
+// change a register are skipped. Every access is counted, so STATS and the
+// scan telemetry show what a gate read costs on the bus. Anything unexpected
+// is reported as READ_FAILED and checkReader() falls back to the library.
+//
+// This file only needs Arduino.h, SPI.h and the MFRC522 library, so
+// tools/reader_emu runs initializeReader() and checkReader() on a Linux
+// machine against an emulated reader. DEBUG comes from main.cpp, which
+// defines it before including the project headers.
+
+#define RST_PIN 21
+#define CS_PIN_2 2
+
+SPISettings mfrc522SPISettings(50000, MSBFIRST, SPI_MODE0);
+SPISettings fastSPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0); // The library's own clock
+
+MFRC522 rfid(CS_PIN_2, RST_PIN);
+
+bool isReaderInitialized = false;
+bool FAST_READER = true;    // Read gates with the lean path, the library is the fallback
+bool TAG_CATEGORIES = true; // Read the category from the tag, the registry is the fallback
+
+enum ReadResult
+{
+  READ_EMPTY, // No tile answered
+  READ_TAG,   // UID (and category) read
+  READ_FAILED // Reader missing or protocol error, read the gate with the library
+};
+
+enum TransceiveStatus
+{
+  XFER_OK,
+  XFER_TIMEOUT, // Reader timer ran out, nothing answered
+  XFER_ERROR
+};
+
+const byte fastPrescaler = 0x43;      // 13.56 MHz / (2 * 0x43 + 1): 10 us timer ticks
+const uint16_t fastReload = 100;      // 1 ms until the answer starts, PCD_Init() allows 25 ms
+const unsigned long fieldOnUs = 5000; // Tiles need up to 5 ms after the field comes on
+const unsigned long replyDelayUs = 91;   // Frame delay time of a tile answer
+const unsigned long pollGapUs = 50;      // Between status reads while the answer is late
+const unsigned long pollLimitUs = 50000; // Give up on a reader that never finishes
+const uint32_t readerInitWatchdogTimeout = 250; // ms, PCD_Init() can block for 150 ms
+const int fastAttempts = 3;
+const int maxBurst = 18;              // READ answers four pages and the CRC
+
+// Shadow of the configuration registers, indexed by register address
+byte shadowRegs[64];
+uint64_t shadowValid = 0;
+
+// Bus accounting, the library path is not counted
+unsigned long spiTransactions = 0; // Chip selects since boot
+unsigned long spiBytes = 0;
+unsigned long skippedWrites = 0;   // Configuration writes that would not change anything
+unsigned long fastReads = 0;       // Gate reads done by the lean path
+unsigned long fastFallbacks = 0;   // Gate reads handed to the library
+uint16_t readTransactions = 0;     // Current gate read
+uint16_t readBytes = 0;
+uint16_t gateTransactions[numGates]; // Last read of each gate
+uint16_t gateBytes[numGates];
+uint32_t scanTransactions[numTables]; // Scan in progress per table, sent with the scan telemetry
+uint32_t scanBytes[numTables];
+byte scanLibraryGates[numTables];     // Gates read by the library, their traffic is not counted
+
+void countTransfer(int bytes)
+{
+  spiTransactions++;
+  spiBytes += bytes;
+  readTransactions++;
+  readBytes += bytes;
+}
+
+// Start counting the accesses of one gate read
+void beginGateRead()
+{
+  readTransactions = 0;
+  readBytes = 0;
+}
+
+void endGateRead(int gate)
+{
+  gateTransactions[gate] = readTransactions;
+  gateBytes[gate] = readBytes;
+}
+
+// Register addresses are the library's, already shifted for the SPI address byte
+void writeRegister(byte reg, byte value)
+{
+  byte frame[2] = {reg, value};
+  digitalWrite(CS_PIN_2, LOW);
+  SPI.transfer(frame, sizeof(frame));
+  digitalWrite(CS_PIN_2, HIGH);
+  countTransfer(sizeof(frame));
+}
+
+// Write reg only when the shadow does not already hold value
+void writeConfig(byte reg, byte value)
+{
+  int index = reg >> 1;
+  if (((shadowValid >> index) & 1) && shadowRegs[index] == value)
+  {
+    skippedWrites++;
+    return;
+  }
+  writeRegister(reg, value);
+  shadowRegs[index] = value;
+  shadowValid |= 1ULL << index;
+}
+
+void assumeRegister(byte reg, byte value)
+{
+  shadowRegs[reg >> 1] = value;
+  shadowValid |= 1ULL << (reg >> 1);
+}
+
+// Read several registers in one chip select: each address byte clocks out
+// the value of the previous one. A register may repeat, the FIFO does.
+void readRegisters(const byte *regs, byte *values, byte count)
+{
+  byte frame[maxBurst + 1];
+  for (byte i = 0; i < count; i++)
+  {
+    frame[i] = 0x80 | regs[i];
+  }
+  frame[count] = 0;
+
+  digitalWrite(CS_PIN_2, LOW);
+  SPI.transfer(frame, count + 1);
+  digitalWrite(CS_PIN_2, HIGH);
+  countTransfer(count + 1);
+
+  for (byte i = 0; i < count; i++)
+  {
+    values[i] = frame[i + 1];
+  }
+}
+
+void readFifo(byte *data, byte count)
+{
+  byte regs[maxBurst];
+  for (byte i = 0; i < count; i++)
+  {
+    regs[i] = MFRC522::FIFODataReg;
+  }
+  readRegisters(regs, data, count);
+}
+
+// The address does not advance in a write burst, every byte goes to the FIFO
+void writeFifo(const byte *data, byte count)
+{
+  byte frame[maxBurst + 1];
+  frame[0] = MFRC522::FIFODataReg;
+  memcpy(frame + 1, data, count);
+
+  digitalWrite(CS_PIN_2, LOW);
+  SPI.transfer(frame, count + 1);
+  digitalWrite(CS_PIN_2, HIGH);
+  countTransfer(count + 1);
+}
+
+// CRC_A of ISO/IEC 14443-3, sent low byte first. Over a frame that ends in
+// its CRC the result is 0.
+uint16_t crcA(const byte *data, byte length)
+{
+  uint16_t crc = 0x6363;
+  for (byte i = 0; i < length; i++)
+  {
+    byte b = data[i] ^ (crc & 0xFF);
+    b ^= b << 4;
+    crc = (crc >> 8) ^ ((uint16_t)b << 8) ^ ((uint16_t)b << 3) ^ (b >> 4);
+  }
+  return crc;
+}
+
+// Check the reader on the open gate and bring it into the configuration the
+// lean path uses. A reader that kept it, or comes out of reset with parts of
+// it, costs no writes for those parts.
+bool prepareReader()
+{
+  const byte regs[] = {MFRC522::VersionReg, MFRC522::TPrescalerReg, MFRC522::TxControlReg};
+  byte values[3];
+  readRegisters(regs, values, 3);
+
+  if (values[0] == 0x00 || values[0] == 0xFF)
+    return false;
+
+  if (values[1] != fastPrescaler)
+  {
+    // Fresh from reset or set up by PCD_Init(): these hold the same values in both
+    shadowValid = 0;
+    assumeRegister(MFRC522::TxModeReg, 0x00);
+    assumeRegister(MFRC522::RxModeReg, 0x00);
+    assumeRegister(MFRC522::ModWidthReg, 0x26);
+  }
+  shadowValid &= ~(1ULL << (MFRC522::BitFramingReg >> 1)); // Differs per reader
+  assumeRegister(MFRC522::TxControlReg, values[2]);
+
+  writeConfig(MFRC522::TxModeReg, 0x00);   // 106 kBd, no CRC
+  writeConfig(MFRC522::RxModeReg, 0x00);
+  writeConfig(MFRC522::ModWidthReg, 0x26);
+  writeConfig(MFRC522::TModeReg, 0x80);    // Timer starts when a frame has been sent
+  writeConfig(MFRC522::TPrescalerReg, fastPrescaler);
+  writeConfig(MFRC522::TReloadRegH, fastReload >> 8);
+  writeConfig(MFRC522::TReloadRegL, fastReload & 0xFF);
+  writeConfig(MFRC522::TxASKReg, 0x40);    // 100% ASK
+  writeConfig(MFRC522::ModeReg, 0x3D);     // CRC preset 0x6363
+
+  if ((values[2] & 0x03) != 0x03)
+  {
+    writeConfig(MFRC522::TxControlReg, values[2] | 0x03); // Antenna on
+    waitUs(fieldOnUs);
+  }
+  return true;
+}
+
+// Microseconds a frame of bytes takes on the air at 106 kBd: 9.44 us per bit,
+// a parity bit per byte, start and end of frame
+unsigned long airUs(byte bytes)
+{
+  return (bytes * 9UL + 2) * 944 / 100;
+}
+
+// Send a frame and collect the answer. lastBits is the bit count of the last
+// byte sent, 0 for whole bytes; received is the expected size on entry and the
+// size on return. The status is first read when the answer can be complete,
+// polling the reader back to back would cost more bus time than the frames.
+byte transceive(const byte *frame, byte length, byte *answer, byte &received, byte lastBits = 0)
+{
+  writeRegister(MFRC522::CommandReg, MFRC522::PCD_Idle);
+  writeRegister(MFRC522::ComIrqReg, 0x7F);     // Clear the interrupt requests
+  writeRegister(MFRC522::FIFOLevelReg, 0x80);  // Flush the FIFO
+  writeFifo(frame, length);
+  writeRegister(MFRC522::CommandReg, MFRC522::PCD_Transceive);
+  writeRegister(MFRC522::BitFramingReg, 0x80 | lastBits); // StartSend
+
+  const byte regs[] = {MFRC522::ComIrqReg, MFRC522::ErrorReg, MFRC522::FIFOLevelReg, MFRC522::ControlReg};
+  byte status[4];
+  unsigned long start = micros();
+  waitUs(airUs(length) + replyDelayUs + airUs(received));
+  while (true)
+  {
+    readRegisters(regs, status, 4);
+    if (status[0] & 0x30) // RxIRq or IdleIRq
+      break;
+    if (status[0] & 0x01) // TimerIRq
+      return XFER_TIMEOUT;
+    if (micros() - start > pollLimitUs)
+      return XFER_ERROR;
+    waitUs(pollGapUs);
+  }
+
+  // BufferOvfl, CollErr, ParityErr, ProtocolErr
+  if (status[1] & 0x1B)
+    return XFER_ERROR;
+
+  byte level = status[2] & 0x7F;
+  if (level > received || (status[3] & 0x07) != 0)
+    return XFER_ERROR;
+  if (level > 0)
+    readFifo(answer, level);
+  received = level;
+  return XFER_OK;
+}
+
+// Select through the cascade levels, 4, 7 and 10 byte UIDs
+byte selectTag(MFRC522::Uid &uid)
+{
+  uid.size = 0;
+  for (int cascade = 0; cascade < 3; cascade++)
+  {
+    byte frame[9] = {(byte)(0x93 + 2 * cascade), 0x20};
+    byte answer[5];
+    byte received = sizeof(answer);
+
+    // Anticollision with no known bits, one tile per gate answers alone
+    if (transceive(frame, 2, answer, received) != XFER_OK || received != 5)
+      return XFER_ERROR;
+    if ((answer[0] ^ answer[1] ^ answer[2] ^ answer[3]) != answer[4])
+      return XFER_ERROR;
+
+    frame[1] = 0x70;
+    memcpy(frame + 2, answer, 5);
+    uint16_t crc = crcA(frame, 7);
+    frame[7] = crc & 0xFF;
+    frame[8] = crc >> 8;
+
+    byte sak[3];
+    received = sizeof(sak);
+    if (transceive(frame, 9, sak, received) != XFER_OK || received != 3 || crcA(sak, 3) != 0)
+      return XFER_ERROR;
+
+    bool more = sak[0] & 0x04; // UID not complete, the answer starts with the cascade tag
+    if (more && answer[0] != 0x88)
+      return XFER_ERROR;
+    for (int i = more ? 1 : 0; i < 4; i++)
+    {
+      uid.uidByte[uid.size++] = answer[i];
+    }
+    if (!more)
+    {
+      uid.sak = sak[0];
+      return XFER_OK;
+    }
+  }
+  return XFER_ERROR;
+}
+
+// Category page of the selected tile, 0 when the tile has none
+byte readCategory(const MFRC522::Uid &uid)
+{
+  byte frame[4] = {0x30, categoryPage}; // READ
+  uint16_t crc = crcA(frame, 2);
+  frame[2] = crc & 0xFF;
+  frame[3] = crc >> 8;
+
+  byte pages[18];
+  byte received = sizeof(pages);
+  if (transceive(frame, 4, pages, received) != XFER_OK || received != 18 || crcA(pages, 18) != 0)
+    return 0; // A NAK leaves 4 bits, tags without the page fall back to the registry
+
+  return pageCategory(pages, uid);
+}
+
+// Read the tile on the open gate. The tile is not halted: WUPA wakes halted
+// tiles anyway, and the gate closes after the read.
+ReadResult fastReadTag(MFRC522::Uid &uid, byte *category)
+{
+  if (!prepareReader())
+    return READ_FAILED;
+
+  bool failed = false;
+  for (int attempt = 0; attempt < fastAttempts; attempt++)
+  {
+    byte wupa = 0x52;
+    byte atqa[2];
+    byte received = sizeof(atqa);
+    byte status = transceive(&wupa, 1, atqa, received, 7);
+    if (status == XFER_TIMEOUT)
+      continue;
+    if (status != XFER_OK || received != 2 || selectTag(uid) != XFER_OK)
+    {
+      failed = true;
+      continue;
+    }
+
+    if (category)
+      *category = readCategory(uid);
+    fastReads++;
+    return READ_TAG;
+  }
+
+  if (failed)
+    return READ_FAILED;
+  fastReads++;
+  return READ_EMPTY;
+}
+
+bool readerAsleep = false; // Soft power-down by sleepReader()
+
+// Soft power-down for the idle manager. Only a reader that stays powered
+// with every gate closed answers here; readers powered through their gate
+// are already off.
+void sleepReader()
+{
+  byte reg = MFRC522::VersionReg;
+  byte version;
+  SPI.beginTransaction(fastSPISettings);
+  readRegisters(&reg, &version, 1);
+  if (version != 0x00 && version != 0xFF)
+  {
+    writeRegister(MFRC522::CommandReg, 0x10); // PowerDown, command Idle
+    readerAsleep = true;
+  }
+  SPI.endTransaction();
+}
+
+// Leave soft power-down without waiting, the oscillator is running again
+// long before the first gate has settled
+void wakeReader()
+{
+  if (!readerAsleep)
+    return;
+  SPI.beginTransaction(fastSPISettings);
+  writeRegister(MFRC522::CommandReg, 0x00);
+  SPI.endTransaction();
+  readerAsleep = false;
+}
+
+void initializeReader()
+{
+  digitalWrite(CS_PIN_2, LOW);
+  waitMs(20);
+  digitalWrite(RST_PIN, HIGH);
+  waitMs(20); // Wait for the reader to reset
+  digitalWrite(RST_PIN, LOW);
+  waitMs(20); // Wait for the reader to stabilize
+  SPI.beginTransaction(mfrc522SPISettings);
+  watchdog_enable(readerInitWatchdogTimeout, true);
+  rfid.PCD_Init();
+  armWatchdog();
+  waitMs(20);
+  SPI.endTransaction();
+  waitMs(20);
+  digitalWrite(CS_PIN_2, HIGH);
+
+  if (DEBUG)
+  {
+    Serial.print("Firmware version: ");
+    rfid.PCD_DumpVersionToSerial();
+  }
+  isReaderInitialized = true;
+}
+
+void checkReader(int gateIndex)
+{
+  byte scannedUID[7] = {0}; // Array to store the scanned UID
+  bool uidFound = false;    // Flag to indicate if a UID was found
+  byte tagCategory = 0;     // Category stored on the tag itself
+  bool libraryRead = true;  // Read with the MFRC522 library
+  const int maxAttempts = 3;
+
+  beginGateRead();
+  if (FAST_READER)
+  {
+    SPI.beginTransaction(fastSPISettings);
+    ReadResult result = fastReadTag(rfid.uid, TAG_CATEGORIES ? &tagCategory : nullptr);
+    SPI.endTransaction();
+
+    if (result != READ_FAILED)
+    {
+      uidFound = result == READ_TAG;
+      libraryRead = false;
+    }
+    else
+    {
+      fastFallbacks++;
+      scanLibraryGates[activeTable] |= 1 << gateIndex;
+    }
+  }
+  endGateRead(tableGate(gateIndex));
+  scanTransactions[activeTable] += readTransactions;
+  scanBytes[activeTable] += readBytes;
+
+  if (libraryRead)
+  {
+    initializeReader(); // Ensure the reader is properly reset
+    waitMs(50);         // Give time to stabilize
+  }
+
+  for (int attempt = 0; libraryRead && attempt < maxAttempts; attempt++)
+  {
+    digitalWrite(CS_PIN_2, LOW);
+    SPI.beginTransaction(mfrc522SPISettings);
+
+    byte bufferATQA[2];
+    byte bufferSize = sizeof(bufferATQA);
+
+    if (rfid.PICC_WakeupA(bufferATQA, &bufferSize) == MFRC522::STATUS_OK)
+    {
+      if (rfid.PICC_Select(&rfid.uid) == MFRC522::STATUS_OK)
+      {
+        // Read the category page in the same session, before halting the tag
+        if (TAG_CATEGORIES)
+        {
+          tagCategory = readTagCategory(rfid);
+        }
+
+        uidFound = true;
+        rfid.PICC_HaltA();
+        rfid.PCD_StopCrypto1();
+        SPI.endTransaction();
+        digitalWrite(CS_PIN_2, HIGH);
+        break; // UID found, break out of retry loop
+      }
+    }
+
+    SPI.endTransaction();
+    digitalWrite(CS_PIN_2, HIGH);
+    waitMs(20); // Wait a bit before retrying
+  }
+
+  if (uidFound)
+  {
+    // Copy the UID into the scannedUID array, 10-byte UIDs are cut short
+    for (byte i = 0; i < rfid.uid.size && i < sizeof(scannedUID); i++)
+    {
+      scannedUID[i] = rfid.uid.uidByte[i];
+    }
+
+    // Print the UID to Serial
+    if (DEBUG)
+    {
+      Serial.print("Card UID at Gate ");
+      Serial.print(gateIndex + 1);
+      Serial.print(": UID: ");
+      for (byte i = 0; i < rfid.uid.size; i++)
+      {
+        Serial.print(rfid.uid.uidByte[i], HEX);
+        if (i < rfid.uid.size - 1)
+        {
+          Serial.print(":");
+        }
+      }
+      Serial.println();
+    }
+  }
+
+  if (uidFound)
+  {
+    // Use the category on the tag, or look the scanned UID up in the registry
+    byte category = tagCategory != 0 ? tagCategory : lookupCategory(scannedUID);
+    if (category != 0)
+    {
+      setGateCard(gateIndex, category); // Update the array with the category
+      if (DEBUG)
+      {
+        Serial.print("Gate ");
+        Serial.print(gateIndex + 1);
+        Serial.print(": Category ");
+        Serial.println(category);
+      }
+      return;
+    }
+
+    // If no match is found
+    setGateCard(gateIndex, 0); // Set to 0 to indicate no match
+    if (DEBUG)
+    {
+      Serial.print("Gate ");
+      Serial.print(gateIndex + 1);
+      Serial.println(": No matching category found.");
+    }
+  }
+  else
+  {
+    setGateCard(gateIndex, 0); // Set to 0 if no UID was found
+    if (DEBUG)
+    {
+      Serial.print("Gate ");
+      Serial.print(gateIndex + 1);
+      Serial.println(": No card detected.");
+    }
+  }
+}
+
+void printReaderStats()
+{
+  Serial.print("Reader: fast reads ");
+  Serial.print(fastReads);
+  Serial.print(", library fallbacks ");
+  Serial.print(fastFallbacks);
+  Serial.print(", SPI ");
+  Serial.print(spiTransactions);
+  Serial.print(" transactions, ");
+  Serial.print(spiBytes);
+  Serial.print(" bytes, skipped writes ");
+  Serial.println(skippedWrites);
+  Serial.print("Last read per gate (transactions/bytes):");
+  for (int i = 0; i < numGates; i++)
+  {
+    Serial.print(" ");
+    Serial.print(gateTransactions[i]);
+    Serial.print("/");
+    Serial.print(gateBytes[i]);
+  }
+  Serial.println();
+}
+
+#endif
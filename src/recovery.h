@@ -0,0 +1,146 @@
+#ifndef RECOVERY_H
+#define RECOVERY_H
+
+#include <hardware/watchdog.h>
+
+// Hardware watchdog and crash recovery. The game state is stashed in the
+// watchdog scratch registers, which survive a watchdog reset, so a hung
+// installation reboots straight back into the level it was in.
+
+// Milliseconds without feeding before a reset. PCD_Init() can block for up to
+// 150 ms while the reader soft-resets, initializeReader() stretches the
+// timeout around it.
+const uint32_t watchdogTimeout = 100;
+const uint32_t recoveryMagic = 0x4E560000;
+
+// Timeout armWatchdog() restores, longer while the idle manager sleeps
+uint32_t watchdogModeTimeout = watchdogTimeout;
+
+// Scratch registers 4 to 7 are used by the SDK, 0 to 3 are ours
+#define SCRATCH_MAGIC 0    // recoveryMagic, low half counts watchdog resets
+#define SCRATCH_STATE 1    // Level and introduction flags per table
+#define SCRATCH_ACTIVITY 2 // What the firmware was doing
+#define SCRATCH_CAUSES 3   // Soft recoveries: audio timeouts and errors
+
+enum Activity
+{
+  ACTIVITY_IDLE,
+  ACTIVITY_BOOT,
+  ACTIVITY_SCAN,
+  ACTIVITY_AUDIO
+};
+
+enum RecoveryCause
+{
+  CAUSE_NONE,
+  CAUSE_AUDIO_TIMEOUT, // No end of track before the deadline
+  CAUSE_AUDIO_ERROR,   // Player reported a missing or unreadable file
+  CAUSE_MISSED_END,    // Player stopped without reporting the end of the track
+  CAUSE_WATCHDOG       // Hung, reset by the watchdog
+};
+
+unsigned long watchdogResets = 0; // Watchdog resets since power-up
+unsigned long audioTimeouts = 0;  // Device waits ended by their deadline
+unsigned long audioErrors = 0;    // Device waits ended by a player error or missed end
+byte lastRecoveryCause = CAUSE_NONE;
+byte hungActivity = ACTIVITY_IDLE; // Activity at the last watchdog reset
+
+void feedWatchdog()
+{
+  watchdog_update();
+}
+
+// delay() that keeps the watchdog fed
+void waitMs(unsigned long ms)
+{
+  unsigned long start = millis();
+  while (millis() - start < ms)
+  {
+    feedWatchdog();
+  }
+}
+
+void setActivity(Activity activity)
+{
+  watchdog_hw->scratch[SCRATCH_ACTIVITY] = activity;
+}
+
+// Every table stashes its level and introduction flags in 10 bits of
+// SCRATCH_STATE, so up to three tables survive a reset
+const int stashedTables = 3;
+
+void stashGameState(int table, int level, bool intro01, bool intro02)
+{
+  uint32_t bits = (level & 0xFF) | (intro01 << 8) | (intro02 << 9);
+  uint32_t state = watchdog_hw->scratch[SCRATCH_STATE] & ~(0x3FFUL << (10 * table));
+  watchdog_hw->scratch[SCRATCH_STATE] = state | (bits << (10 * table));
+}
+
+void recordRecovery(RecoveryCause cause)
+{
+  lastRecoveryCause = cause;
+  if (cause == CAUSE_AUDIO_TIMEOUT)
+    audioTimeouts++;
+  else
+    audioErrors++;
+
+  watchdog_hw->scratch[SCRATCH_CAUSES] = (audioTimeouts << 16) | (audioErrors & 0xFFFF);
+}
+
+// Check whether this boot follows a watchdog reset, returns false after a
+// normal power-up or reset, which starts the game from the beginning. A
+// reboot requested through the watchdog is not a hang.
+bool recoverFromWatchdog()
+{
+  bool recovered = watchdog_enable_caused_reboot() &&
+                   (watchdog_hw->scratch[SCRATCH_MAGIC] & 0xFFFF0000) == recoveryMagic;
+
+  if (recovered)
+  {
+    watchdogResets = (watchdog_hw->scratch[SCRATCH_MAGIC] & 0xFFFF) + 1;
+    hungActivity = watchdog_hw->scratch[SCRATCH_ACTIVITY];
+    audioTimeouts = watchdog_hw->scratch[SCRATCH_CAUSES] >> 16;
+    audioErrors = watchdog_hw->scratch[SCRATCH_CAUSES] & 0xFFFF;
+    lastRecoveryCause = CAUSE_WATCHDOG;
+  }
+  else
+  {
+    watchdog_hw->scratch[SCRATCH_STATE] = 0;
+    watchdog_hw->scratch[SCRATCH_CAUSES] = 0;
+  }
+
+  watchdog_hw->scratch[SCRATCH_MAGIC] = recoveryMagic | (watchdogResets & 0xFFFF);
+  setActivity(ACTIVITY_BOOT);
+  return recovered;
+}
+
+// Restore the state a table stashed before the watchdog reset
+void restoreGameState(int table, int &level, bool &intro01, bool &intro02)
+{
+  uint32_t bits = watchdog_hw->scratch[SCRATCH_STATE] >> (10 * table);
+  level = bits & 0xFF;
+  intro01 = bits & (1 << 8);
+  intro02 = bits & (1 << 9);
+}
+
+// Back to the timeout of the current mode, also after a longer one for flash work
+void armWatchdog()
+{
+  watchdog_enable(watchdogModeTimeout, true); // Paused while a debugger halts the cores
+}
+
+void printRecoveryStats()
+{
+  Serial.print("Recovery: watchdog resets ");
+  Serial.print(watchdogResets);
+  Serial.print(" (last during activity ");
+  Serial.print(hungActivity);
+  Serial.print("), audio timeouts ");
+  Serial.print(audioTimeouts);
+  Serial.print(", audio errors ");
+  Serial.print(audioErrors);
+  Serial.print(", last cause ");
+  Serial.println(lastRecoveryCause);
+}
+
+#endif
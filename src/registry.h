@@ -0,0 +1,186 @@
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include "UID.h"
+
+// Compact tag registry built at compile time from registered[] in UID.h.
+//
+// NXP 7-byte UIDs share the manufacturer byte and, per production batch, the
+// last four bytes. Those five bytes go into a sorted suffix dictionary of
+// 64-bit words. Every tag is then one 32-bit word: dictionary index, the two
+// remaining UID bytes and the category. Both tables are sorted, so a lookup is two binary
+// searches. registered[] itself is only read by the compiler; the templates
+// also pack other tag lists, tools/bench builds large registries with them.
+//
+// Registries beyond roughly 20k tags need the raised -fconstexpr-ops-limit
+// from platformio.ini.
+
+const int uidSuffixLength = 5; // uid[0] and uid[3] to uid[6]
+
+// Suffix bytes of a UID packed into one integer, uid[0] most significant
+constexpr uint64_t uidSuffix(const byte *uid)
+{
+  return ((uint64_t)uid[0] << 32) | ((uint64_t)uid[3] << 24) | ((uint64_t)uid[4] << 16) |
+         ((uint64_t)uid[5] << 8) | uid[6];
+}
+
+// Sort key of a tag: suffix, uid[1], uid[2] and the category in the low byte
+constexpr uint64_t tagKey(const TagEntry &tag)
+{
+  return (uidSuffix(tag.uid) << 24) | ((uint64_t)tag.uid[1] << 16) | ((uint64_t)tag.uid[2] << 8) |
+         tag.category;
+}
+
+template <int N>
+struct SortedTags
+{
+  uint64_t keys[N];
+};
+
+// Heap sort, O(N log N) so the compiler copes with large registries
+template <int N>
+constexpr void siftDown(SortedTags<N> &s, int root, int end)
+{
+  while (2 * root + 1 < end)
+  {
+    int child = 2 * root + 1;
+    if (child + 1 < end && s.keys[child] < s.keys[child + 1])
+      child++;
+    if (s.keys[root] >= s.keys[child])
+      return;
+    uint64_t swap = s.keys[root];
+    s.keys[root] = s.keys[child];
+    s.keys[child] = swap;
+    root = child;
+  }
+}
+
+template <int N>
+constexpr SortedTags<N> sortTags(const TagEntry (&tags)[N])
+{
+  SortedTags<N> s = {};
+  for (int i = 0; i < N; i++)
+  {
+    s.keys[i] = tagKey(tags[i]);
+  }
+  for (int i = N / 2 - 1; i >= 0; i--)
+  {
+    siftDown(s, i, N);
+  }
+  for (int end = N - 1; end > 0; end--)
+  {
+    uint64_t swap = s.keys[0];
+    s.keys[0] = s.keys[end];
+    s.keys[end] = swap;
+    siftDown(s, 0, end);
+  }
+  return s;
+}
+
+template <int N>
+constexpr int countSuffixes(const SortedTags<N> &sorted)
+{
+  int count = N > 0 ? 1 : 0;
+  for (int i = 1; i < N; i++)
+  {
+    if (sorted.keys[i - 1] >> 24 != sorted.keys[i] >> 24)
+      count++;
+  }
+  return count;
+}
+
+constexpr SortedTags<registeredCount> sortedTags = sortTags(registered);
+
+constexpr int registrySuffixCount = countSuffixes(sortedTags);
+
+static_assert(registrySuffixCount <= 256, "Too many UID suffixes for an 8-bit dictionary index");
+
+template <int N, int D>
+struct PackedRegistry
+{
+  uint64_t suffixes[D]; // Sorted suffix dictionary, see uidSuffix()
+  uint32_t tags[N];     // Index << 24 | uid[1] << 16 | uid[2] << 8 | category
+  int duplicates;       // UIDs registered more than once
+};
+
+template <int N, int D>
+constexpr PackedRegistry<N, D> packRegistry(const SortedTags<N> &sorted)
+{
+  PackedRegistry<N, D> r = {};
+  int suffix = -1;
+
+  for (int i = 0; i < N; i++)
+  {
+    uint64_t key = sorted.keys[i];
+
+    if (i == 0 || sorted.keys[i - 1] >> 24 != key >> 24)
+    {
+      suffix++;
+      r.suffixes[suffix] = key >> 24;
+    }
+    else if (sorted.keys[i - 1] >> 8 == key >> 8)
+    {
+      r.duplicates++;
+    }
+
+    r.tags[i] = ((uint32_t)suffix << 24) | (key & 0xFFFFFF);
+  }
+  return r;
+}
+
+constexpr PackedRegistry<registeredCount, registrySuffixCount> packedRegistry =
+    packRegistry<registeredCount, registrySuffixCount>(sortedTags);
+
+static_assert(packedRegistry.duplicates == 0, "A UID is registered more than once");
+
+// Category of a scanned UID in a packed registry, 0 when the tag is not in it
+template <int N, int D>
+byte lookupTag(const PackedRegistry<N, D> &r, const byte *uid)
+{
+  // Find the suffix in the dictionary
+  uint64_t scanned = uidSuffix(uid);
+  int low = 0;
+  int high = D - 1;
+  int suffix = -1;
+  while (low <= high)
+  {
+    int mid = (low + high) / 2;
+    if (r.suffixes[mid] == scanned)
+    {
+      suffix = mid;
+      break;
+    }
+    if (scanned < r.suffixes[mid])
+      high = mid - 1;
+    else
+      low = mid + 1;
+  }
+
+  if (suffix < 0)
+    return 0;
+
+  // Find the tag, the category in the low byte does not take part
+  uint32_t key = ((uint32_t)suffix << 16) | (uid[1] << 8) | uid[2];
+  low = 0;
+  high = N - 1;
+  while (low <= high)
+  {
+    int mid = (low + high) / 2;
+    uint32_t stored = r.tags[mid] >> 8;
+    if (stored == key)
+      return r.tags[mid] & 0xFF;
+    if (key < stored)
+      high = mid - 1;
+    else
+      low = mid + 1;
+  }
+  return 0;
+}
+
+// Category of a scanned UID, 0 when the tag is not registered
+byte lookupCategory(const byte *uid)
+{
+  return lookupTag(packedRegistry, uid);
+}
+
+#endif
@@ -0,0 +1,663 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include "UID.h"
+#include "levelpack.h"
+#include "lvl.h"
+
+// Board state and the rule chain of every level. This header has no
+// Arduino dependencies so the host tools in tools/ can include it as-is.
+// The levels below are built in; a level pack (levelpack.h) replaces them
+// without a recompile while levelPack points to one.
+
+const int numGatePins = 6;
+const int numLevels = 6;
+
+byte presentCards[numGatePins]; // Array to store the present card for each gate
+
+// Packed board state kept up to date by setGateCard(). Bits 4 * (c - 1) to
+// 4 * c - 1 count the cards of category c, the top byte holds the occupied
+// gates, so two board states compare as a single word.
+uint64_t boardState = 0;
+const int occupancyShift = 56;
+
+const LevelPack *levelPack = nullptr; // Levels in use, nullptr for the built-in ones
+
+// Branch of the rule chain that decided the outcome of a button press
+enum Branch
+{
+  BRANCH_MASK,          // Occupied gates match no connection mask
+  BRANCH_ILLEGAL,       // Component not allowed in this level
+  BRANCH_RULE_0,        // lvlN_0, the level is completed
+  BRANCH_RULE_1,        // lvlN_1
+  BRANCH_RULE_2,        // lvlN_2
+  BRANCH_RULE_3,        // lvlN_3
+  BRANCH_FALLBACK,      // No rule matched
+  BRANCH_INVALID_LEVEL, // Level outside the rule set
+  BRANCH_COUNT
+};
+
+struct Outcome
+{
+  byte branch;   // Branch that decided the outcome
+  byte track;    // Track in folder 01 to play, 0 for none
+  int nextLevel; // Level after this outcome
+};
+
+// Categories that every rule treats alike
+enum Group
+{
+  GROUP_LINE,
+  GROUP_T_JUNCTION,
+  GROUP_LED,
+  GROUP_SW,
+  GROUP_PUSH_SW,
+  GROUP_RESISTOR,
+  GROUP_PHOTODIODE,
+  GROUP_COUNT
+};
+
+// Count bits of one category in boardState
+constexpr uint64_t categoryBits(int category)
+{
+  return 0xFULL << (4 * (category - 1));
+}
+
+// Count bits of the categories in each group
+const uint64_t groupMasks[GROUP_COUNT] = {
+    categoryBits(LINE_STRAIGHT) | categoryBits(LINE_CORNER),
+    categoryBits(LINE_T_JUNCTION),
+    categoryBits(LED_STRAIGHT) | categoryBits(LED_CORNER_R) | categoryBits(LED_CORNER_L),
+    categoryBits(SW_STRAIGHT) | categoryBits(SW_CORNER),
+    categoryBits(PUSH_SW_STRAIGHT) | categoryBits(PUSH_SW_CORNER),
+    categoryBits(RESISTOR_STRAIGHT) | categoryBits(RESISTOR_CORNER),
+    categoryBits(PHOTODIODE)};
+
+// First category of each group, used to build a board for a histogram
+const byte groupCategory[GROUP_COUNT] = {
+    LINE_STRAIGHT, LINE_T_JUNCTION, LED_STRAIGHT, SW_STRAIGHT,
+    PUSH_SW_STRAIGHT, RESISTOR_STRAIGHT, PHOTODIODE};
+
+// Place a card on a gate and update boardState
+void setGateCard(int gate, byte category)
+{
+  byte old = presentCards[gate];
+  if (old >= 1 && old <= 13)
+  {
+    boardState -= 1ULL << (4 * (old - 1));
+  }
+  if (category >= 1 && category <= 13)
+  {
+    boardState += 1ULL << (4 * (category - 1));
+  }
+
+  if (category != 0)
+  {
+    boardState |= 1ULL << (occupancyShift + gate);
+  }
+  else
+  {
+    boardState &= ~(1ULL << (occupancyShift + gate));
+  }
+  presentCards[gate] = category;
+}
+
+// Rebuild boardState after presentCards was written directly
+void countCards()
+{
+  boardState = 0;
+  for (int i = 0; i < numGatePins; i++)
+  {
+    byte val = presentCards[i];
+    presentCards[i] = 0;
+    setGateCard(i, val);
+  }
+}
+
+// Number of cards in the categories under mask. Each count is at most
+// numGatePins, so the nibbles are summed pairwise into bytes, the halves
+// folded into 32 bits and the bytes added with one 32-bit multiply.
+int countCategories(uint64_t mask)
+{
+  uint64_t x = boardState & mask;
+  x = (x & 0x0F0F0F0F0F0F0F0FULL) + ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL);
+  uint32_t y = (uint32_t)x + (uint32_t)(x >> 32);
+  return (uint32_t)(y * 0x01010101u) >> 24;
+}
+
+int groupTotal(int group)
+{
+  return countCategories(groupMasks[group]);
+}
+
+// Bit i is set when gate i holds a card
+byte occupancyMask()
+{
+  return boardState >> occupancyShift;
+}
+
+// True when every card on the board is one of the 13 counted categories.
+// Admin keys and unknown categories occupy a gate without a count, so the
+// histogram alone does not describe the board.
+bool boardCounted()
+{
+  return __builtin_popcount(occupancyMask()) == countCategories((1ULL << (4 * 13)) - 1);
+}
+
+bool hasIllegalComponents(int level)
+{
+  if (levelPack != nullptr)
+  {
+    uint16_t allowed = packLevels(levelPack)[level].allowed;
+    for (int i = 0; i < numGatePins; i++)
+    {
+      int val = presentCards[i];
+      if (val != 0 && (val > 15 || ((allowed >> val) & 1) == 0))
+        return true;
+    }
+    return false;
+  }
+
+  const int *allowed = allowedComponents[level];
+  int count = allowedComponentsCount[level];
+
+  for (int i = 0; i < numGatePins; i++)
+  {
+    int val = presentCards[i];
+    if (val == 0)
+      continue;
+
+    bool isAllowed = false;
+    for (int j = 0; j < count; j++)
+    {
+      if (val == allowed[j])
+      {
+        isAllowed = true;
+        break;
+      }
+    }
+
+    if (!isAllowed)
+      return true;
+  }
+
+  return false;
+}
+
+bool matchConnectionMasks()
+{
+  if (levelPack != nullptr)
+  {
+    int mask = 0;
+    for (int j = 0; j < numGatePins; j++)
+    {
+      if (presentCards[j] != 0)
+        mask |= 1 << j;
+    }
+    return (levelPack->masks >> mask) & 1;
+  }
+
+  for (int i = 0; i < connectionMasksCount; i++)
+  {
+    bool match = true;
+    for (int j = 0; j < numGatePins; j++)
+    {
+      if (connectionMasks[i][j] == 0 && presentCards[j] != 0)
+      {
+        match = false;
+        break;
+      }
+      else if (connectionMasks[i][j] == 1 && presentCards[j] == 0)
+      {
+        match = false;
+        break;
+      }
+    }
+    if (match)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// LEVEL 0
+bool lvl0_0()
+{
+  // geen extra voorwaarden, alleen toegestane lijnen
+  return true;
+}
+
+// LEVEL 1
+bool lvl1_0()
+{
+  // 1 weerstand en 1 led
+  int totalLEDs = groupTotal(GROUP_LED);
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+
+  return (totalLEDs == 1 && totalResistors == 1);
+}
+
+bool lvl1_1()
+{
+  // geen led aanwezig
+  int totalLEDs = groupTotal(GROUP_LED);
+
+  return (totalLEDs == 0);
+}
+
+bool lvl1_2()
+{
+  // geen weerstand aanwezig
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+
+  return (totalResistors == 0);
+}
+
+// LEVEL 2
+bool lvl2_0()
+{
+  // één SW, één led, en één weerstand
+  int totalSW = groupTotal(GROUP_SW); // Normale switches
+  int totalLEDs = groupTotal(GROUP_LED);
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+
+  return (totalSW == 1 && totalLEDs == 1 && totalResistors == 1);
+}
+
+bool lvl2_1()
+{
+  // Nieuwe conditie: geen weerstand
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+
+  return (totalResistors == 0);
+}
+
+bool lvl2_2()
+{
+  // (was lvl2_1) één LED, één weerstand, en geen SW
+  int totalSW = groupTotal(GROUP_SW); // Normale switches
+  int totalLEDs = groupTotal(GROUP_LED);
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+
+  return (totalSW == 0 && totalLEDs == 1 && totalResistors == 1);
+}
+
+bool lvl2_3()
+{
+  // (was lvl2_2) één SW, en geen LED
+  int totalSW = groupTotal(GROUP_SW); // Normale switches
+  int totalLEDs = groupTotal(GROUP_LED);
+
+  return (totalSW == 1 && totalLEDs == 0);
+}
+
+// LEVEL 3
+bool lvl3_0()
+{
+  // één PushSW, één led, en één weerstand
+  int totalPushSW = groupTotal(GROUP_PUSH_SW); // Push switches
+  int totalLEDs = groupTotal(GROUP_LED);
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+
+  return (totalPushSW == 1 && totalLEDs == 1 && totalResistors == 1);
+}
+
+bool lvl3_1()
+{
+  // Nieuwe conditie: geen weerstand
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+
+  return (totalResistors == 0);
+}
+
+bool lvl3_2()
+{
+  // (was lvl3_1) één SW, één led, en één weerstand
+  int totalSW = groupTotal(GROUP_SW); // Normale switches
+  int totalLEDs = groupTotal(GROUP_LED);
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+
+  return (totalSW == 1 && totalLEDs == 1 && totalResistors == 1);
+}
+
+bool lvl3_3()
+{
+  // (was lvl3_2) geen PushSW
+  int totalPushSW = groupTotal(GROUP_PUSH_SW); // Push switches
+
+  return (totalPushSW == 0);
+}
+
+// LEVEL 4
+bool lvl4_0()
+{
+  // 2 weerstanden en 2 LED
+  int totalLEDs = groupTotal(GROUP_LED);
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+
+  return (totalLEDs == 2 && totalResistors == 2);
+}
+
+bool lvl4_1()
+{
+  // Nieuwe conditie: geen weerstand
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+
+  return (totalResistors == 0);
+}
+
+bool lvl4_2()
+{
+  // (was lvl4_1) 1 weerstand en 2 LED
+  int totalLEDs = groupTotal(GROUP_LED);
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+
+  return (totalLEDs == 2 && totalResistors == 1);
+}
+
+bool lvl4_3()
+{
+  // (was lvl4_2) 1 LED
+  int totalLEDs = groupTotal(GROUP_LED);
+
+  return (totalLEDs == 1);
+}
+
+// LEVEL 5
+bool lvl5_0()
+{
+  // 1 fotodiode, 1 weerstand, een PushSW, een LED en een T-junction
+  int totalPhotodiodes = groupTotal(GROUP_PHOTODIODE);
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+  int totalPushSW = groupTotal(GROUP_PUSH_SW); // Push switches
+  int totalLEDs = groupTotal(GROUP_LED);
+  int totalTJunctions = groupTotal(GROUP_T_JUNCTION);
+
+  return (totalPhotodiodes == 1 && totalResistors == 1 && totalPushSW == 1 && totalLEDs == 1 && totalTJunctions == 1);
+}
+
+bool lvl5_1()
+{
+  // Nieuwe conditie: geen weerstand
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+
+  return (totalResistors == 0);
+}
+
+bool lvl5_2()
+{
+  // (was lvl5_1) geen fotodiode en/of geen PushSW
+  int totalPhotodiodes = groupTotal(GROUP_PHOTODIODE);
+  int totalPushSW = groupTotal(GROUP_PUSH_SW); // Push switches
+
+  return (totalPhotodiodes == 0 || totalPushSW == 0);
+}
+
+bool lvl5_3()
+{
+  // (was lvl5_2) geen weerstand en/of geen t-junction
+  int totalResistors = groupTotal(GROUP_RESISTOR);
+  int totalTJunctions = groupTotal(GROUP_T_JUNCTION);
+
+  return (totalResistors == 0 || totalTJunctions == 0);
+}
+
+const int maxRulesPerLevel = 4;
+
+// Inputs a rule reads, so the incremental evaluator knows when to rerun it
+enum RuleInput
+{
+  IN_LINE = 1 << GROUP_LINE,
+  IN_T_JUNCTION = 1 << GROUP_T_JUNCTION,
+  IN_LED = 1 << GROUP_LED,
+  IN_SW = 1 << GROUP_SW,
+  IN_PUSH_SW = 1 << GROUP_PUSH_SW,
+  IN_RESISTOR = 1 << GROUP_RESISTOR,
+  IN_PHOTODIODE = 1 << GROUP_PHOTODIODE,
+  IN_CARDS = 1 << GROUP_COUNT // Category and gate of every card
+};
+
+struct LevelRules
+{
+  bool (*rules[maxRulesPerLevel])(); // Rule chain, the first matching rule wins
+  uint16_t reads[maxRulesPerLevel];  // Inputs of each rule
+  byte tracks[maxRulesPerLevel];     // Track played for each rule
+  byte followUpTrack;                // Track played after completing the level
+  int nextLevel;                     // Level after completing this one
+};
+
+// rules[0] completes the level, the others are error hints
+const LevelRules levelRules[numLevels] = {
+    {{lvl0_0, nullptr, nullptr, nullptr},
+     {0, 0, 0, 0},
+     {4, 0, 0, 0}, 6, 1},
+    {{lvl1_0, lvl1_1, lvl1_2, nullptr},
+     {IN_LED | IN_RESISTOR, IN_LED, IN_RESISTOR, 0},
+     {7, 8, 9, 0}, 10, 2},
+    {{lvl2_0, lvl2_1, lvl2_2, lvl2_3},
+     {IN_SW | IN_LED | IN_RESISTOR, IN_RESISTOR, IN_SW | IN_LED | IN_RESISTOR, IN_SW | IN_LED},
+     {11, 9, 12, 13}, 14, 3},
+    {{lvl3_0, lvl3_1, lvl3_2, lvl3_3},
+     {IN_PUSH_SW | IN_LED | IN_RESISTOR, IN_RESISTOR, IN_SW | IN_LED | IN_RESISTOR, IN_PUSH_SW},
+     {15, 9, 16, 17}, 18, 4},
+    {{lvl4_0, lvl4_1, lvl4_2, lvl4_3},
+     {IN_LED | IN_RESISTOR, IN_RESISTOR, IN_LED | IN_RESISTOR, IN_LED},
+     {19, 9, 20, 21}, 22, 5},
+    {{lvl5_0, lvl5_1, lvl5_2, lvl5_3},
+     {IN_PHOTODIODE | IN_RESISTOR | IN_PUSH_SW | IN_LED | IN_T_JUNCTION, IN_RESISTOR, IN_PHOTODIODE | IN_PUSH_SW, IN_RESISTOR | IN_T_JUNCTION},
+     {23, 9, 24, 25}, 26, 10}};
+
+// Cues the admin actions replay per level, 0 when the level has none
+const byte errorTracks[packAdminErrors][numLevels] = {
+    {5, 8, 9, 9, 9, 9},
+    {0, 9, 12, 16, 20, 24},
+    {0, 0, 13, 17, 21, 25}};
+const byte restartTracks[numLevels] = {3, 6, 10, 14, 18, 22};
+
+// Level data from the pack when one is loaded, else from the tables above
+
+bool ruleDefined(int level, int rule)
+{
+  if (levelPack != nullptr)
+    return rule < packLevels(levelPack)[level].rules;
+  return levelRules[level].rules[rule] != nullptr;
+}
+
+bool runRule(int level, int rule)
+{
+  if (levelPack == nullptr)
+    return levelRules[level].rules[rule]();
+
+  byte totals[GROUP_COUNT];
+  for (int g = 0; g < GROUP_COUNT; g++)
+  {
+    totals[g] = groupTotal(g);
+  }
+  return packRuleHolds(packLevels(levelPack)[level].rule[rule], totals);
+}
+
+// Inputs of a rule, see RuleInput
+uint16_t ruleReads(int level, int rule)
+{
+  if (levelPack == nullptr)
+    return levelRules[level].reads[rule];
+
+  uint16_t reads = 0;
+  const PackRule &r = packLevels(levelPack)[level].rule[rule];
+  for (int i = 0; i < r.terms; i++)
+  {
+    reads |= 1 << r.term[i].group;
+  }
+  return reads;
+}
+
+byte ruleTrack(int level, int rule)
+{
+  if (levelPack != nullptr)
+    return packLevels(levelPack)[level].rule[rule].track;
+  return levelRules[level].tracks[rule];
+}
+
+byte levelFollowUp(int level)
+{
+  return levelPack != nullptr ? packLevels(levelPack)[level].followUpTrack : levelRules[level].followUpTrack;
+}
+
+int levelNext(int level)
+{
+  return levelPack != nullptr ? packLevels(levelPack)[level].nextLevel : levelRules[level].nextLevel;
+}
+
+// Track of admin error 1 to 3
+byte errorTrack(int level, int error)
+{
+  return levelPack != nullptr ? packLevels(levelPack)[level].errorTracks[error - 1] : errorTracks[error - 1][level];
+}
+
+byte restartTrack(int level)
+{
+  return levelPack != nullptr ? packLevels(levelPack)[level].restartTrack : restartTracks[level];
+}
+
+// Reason a pack cannot replace the built-in levels, nullptr when it can. The
+// decision table and the hints count groups, not categories, so a level must
+// allow every category of a group or none.
+const char *levelPackProblem(const byte *data, uint32_t size)
+{
+  const char *problem = packProblem(data, size, numLevels, GROUP_COUNT);
+  if (problem != nullptr)
+    return problem;
+
+  const LevelPack *pack = (const LevelPack *)data;
+  for (int l = 0; l < numLevels; l++)
+  {
+    uint64_t allowed = 0;
+    for (int c = 1; c <= 13; c++)
+    {
+      if ((packLevels(pack)[l].allowed >> c) & 1)
+        allowed |= categoryBits(c);
+    }
+    for (int g = 0; g < GROUP_COUNT; g++)
+    {
+      if ((allowed & groupMasks[g]) != 0 && (allowed & groupMasks[g]) != groupMasks[g])
+        return "a level allows part of a group";
+    }
+    if (packLevels(pack)[l].allowed & ~(uint16_t)0x3FFE)
+      return "unknown category allowed";
+  }
+  return nullptr;
+}
+
+// Outcome of a branch of the rule chain of a level
+Outcome outcomeFromBranch(int level, int branch)
+{
+  switch (branch)
+  {
+  case BRANCH_MASK:
+    return {BRANCH_MASK, levelPack != nullptr ? levelPack->maskTrack : (byte)5, level};
+  case BRANCH_ILLEGAL:
+    return {BRANCH_ILLEGAL, levelPack != nullptr ? levelPack->illegalTrack : (byte)2, level};
+  case BRANCH_RULE_0:
+    return {BRANCH_RULE_0, ruleTrack(level, 0), levelNext(level)};
+  case BRANCH_RULE_1:
+  case BRANCH_RULE_2:
+  case BRANCH_RULE_3:
+    return {(byte)branch, ruleTrack(level, branch - BRANCH_RULE_0), level};
+  case BRANCH_FALLBACK:
+    return {BRANCH_FALLBACK, levelPack != nullptr ? levelPack->fallbackTrack : (byte)2, level};
+  default:
+    return {BRANCH_INVALID_LEVEL, 0, 10};
+  }
+}
+
+// Branch taken by the rule chain of a level, without the topology check
+int evaluateRules(int level)
+{
+  if (level < 0 || level >= numLevels)
+  {
+    return BRANCH_INVALID_LEVEL;
+  }
+
+  if (hasIllegalComponents(level))
+  {
+    return BRANCH_ILLEGAL;
+  }
+
+  for (int i = 0; i < maxRulesPerLevel; i++)
+  {
+    if (ruleDefined(level, i) && runRule(level, i))
+    {
+      return BRANCH_RULE_0 + i;
+    }
+  }
+
+  return BRANCH_FALLBACK;
+}
+
+// Evaluate the board against the rule chain of a level
+Outcome evaluateBoard(int level)
+{
+  if (!matchConnectionMasks())
+  {
+    return outcomeFromBranch(level, BRANCH_MASK);
+  }
+
+  return outcomeFromBranch(level, evaluateRules(level));
+}
+
+constexpr int binomial(int n, int k)
+{
+  return k == 0 ? 1 : binomial(n - 1, k - 1) * n / k;
+}
+
+// Number of group histograms over groups g and up holding at most n cards
+constexpr int histogramsUpTo(int g, int n)
+{
+  return binomial(n + GROUP_COUNT - g, GROUP_COUNT - g);
+}
+
+const int numHistograms = histogramsUpTo(0, numGatePins);
+
+struct RankTable
+{
+  // step[g][n][c]: histograms skipped when group g holds c of n remaining cards
+  uint16_t step[GROUP_COUNT][numGatePins + 1][numGatePins + 1];
+};
+
+constexpr RankTable makeRankTable()
+{
+  RankTable table = {};
+  for (int g = 0; g < GROUP_COUNT; g++)
+  {
+    for (int n = 0; n <= numGatePins; n++)
+    {
+      int skipped = 0;
+      for (int c = 0; c <= n; c++)
+      {
+        table.step[g][n][c] = skipped;
+        skipped += histogramsUpTo(g + 1, n - c);
+      }
+    }
+  }
+  return table;
+}
+
+constexpr RankTable rankTable = makeRankTable();
+
+// Position of the group histogram of boardState among all histograms of at
+// most numGatePins cards, from 0 to numHistograms - 1
+int boardRank()
+{
+  int rank = 0;
+  int left = numGatePins;
+  for (int g = 0; g < GROUP_COUNT; g++)
+  {
+    int count = groupTotal(g);
+    rank += rankTable.step[g][left][count];
+    left -= count;
+  }
+  return rank;
+}
+
+#endif
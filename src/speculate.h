@@ -0,0 +1,161 @@
+#ifndef SPECULATE_H
+#define SPECULATE_H
+
+#include <string.h>
+#include "decision.h"
+#include "gates.h"
+#include "incremental.h"
+#include "reader.h"
+#include "tables.h"
+
+// Speculative evaluation. While the players rearrange the tiles after a
+// verdict the reader is free, so the board of an idle table is read again in
+// the background, one gate per specGateMs. When a sweep ends on a board that
+// was not evaluated yet, it is evaluated and the first track of its verdict is
+// pre-armed on the player. A press still scans and confirms the board; if the
+// result is the speculated board the cached verdict is used and the cue only
+// resumes the armed track. A background read that disagrees with the
+// speculated board just clears specValid, the armed track stays harmless
+// until a cue plays something else.
+
+const unsigned long specWindowMs = 60000; // Watch the board this long after the last cue
+const unsigned long specGateMs = 50;      // One background read per interval
+
+// Counters for STATS
+unsigned long specEvaluations = 0; // Boards evaluated ahead of a press
+unsigned long specDiscards = 0;    // Speculations dropped by a later read
+unsigned long specHits = 0;        // Presses answered by the speculation
+unsigned long specMisses = 0;      // Presses on another board than the speculated one
+unsigned long specCold = 0;        // Presses without a speculation
+
+// Start watching the board of a table, called when its cues are done
+void watchBoard(Table &t)
+{
+  t.specUntil = millis() + specWindowMs;
+}
+
+bool watchingBoard(const Table &t)
+{
+  return t.phase == TABLE_IDLE && !t.pressPending && t.cueCount == 0 && (long)(t.specUntil - millis()) > 0;
+}
+
+// CUE_PLAY value of the first track the cues of a verdict play, 0 for none
+uint16_t verdictCue(const Outcome &outcome)
+{
+  if (outcome.branch == BRANCH_INVALID_LEVEL || outcome.track == 0)
+    return 0;
+  return 1 << 8 | outcome.track;
+}
+
+// Admin keys are handled at the press, never ahead of it
+bool adminKeyOnBoard()
+{
+  for (int i = 0; i < numGatePins; i++)
+  {
+    if (presentCards[i] >= ADMIN_KEY_A && presentCards[i] <= ADMIN_KEY_J)
+      return true;
+  }
+  return false;
+}
+
+// Background read of one gate of the active table, the board is evaluated
+// after the last gate of a sweep
+void speculateGate()
+{
+  Table &t = *table;
+  int gate = t.specGate;
+
+  // Background reads stay out of the bus counts of the next scan
+  uint32_t transactions = scanTransactions[activeTable];
+  uint32_t bytes = scanBytes[activeTable];
+  byte libraryGates = scanLibraryGates[activeTable];
+  setActivity(ACTIVITY_SCAN);
+  openGate(tableGate(gate));
+  settleGate(tableGate(gate));
+  checkReader(gate);
+  closeGates();
+  scanTransactions[activeTable] = transactions;
+  scanBytes[activeTable] = bytes;
+  scanLibraryGates[activeTable] = libraryGates;
+
+  t.specLast = millis();
+  if (t.specValid && (presentCards[gate] != t.specCards[gate] || t.specLevel != currentLevel))
+  {
+    t.specValid = false;
+    specDiscards++;
+  }
+
+  t.specGate = (gate + 1) % numGatePins;
+  if (t.specGate != 0 || t.specValid || adminKeyOnBoard())
+    return;
+
+  t.specOutcome = decisionTableValid ? lookupOutcome(currentLevel) : evaluateIncremental(currentLevel);
+  memcpy(t.specCards, presentCards, sizeof(t.specCards));
+  t.specLevel = currentLevel;
+  t.specValid = true;
+  specEvaluations++;
+
+  uint16_t cue = verdictCue(t.specOutcome);
+  if (cue != 0)
+    t.armWant = cue;
+}
+
+// Give the free reader to the watched table read longest ago
+void speculate()
+{
+  int next = -1;
+  for (int t = 0; t < numTables; t++)
+  {
+    const Table &s = tables[t];
+    if (!watchingBoard(s) || millis() - s.specLast < specGateMs)
+      continue;
+    if (next < 0 || (long)(s.specLast - tables[next].specLast) < 0)
+      next = t;
+  }
+  if (next < 0)
+    return;
+
+  selectTable(next);
+  speculateGate();
+}
+
+// At a press, after the confirmation: true when the board is the speculated
+// one. The speculation is used up either way, so the next sweep arms again.
+bool speculationHolds()
+{
+  Table &t = *table;
+  if (!t.specValid)
+  {
+    specCold++;
+    return false;
+  }
+
+  t.specValid = false;
+  if (t.specLevel != currentLevel || memcmp(t.specCards, presentCards, sizeof(t.specCards)) != 0)
+  {
+    specMisses++;
+    return false;
+  }
+  specHits++;
+  return true;
+}
+
+void printSpeculationStats()
+{
+  Serial.print("Speculation: evaluated ");
+  Serial.print(specEvaluations);
+  Serial.print(", discarded ");
+  Serial.print(specDiscards);
+  Serial.print(", presses hit ");
+  Serial.print(specHits);
+  Serial.print(", missed ");
+  Serial.print(specMisses);
+  Serial.print(", cold ");
+  Serial.print(specCold);
+  Serial.print(", tracks armed ");
+  Serial.print(armsReady);
+  Serial.print(", resumed ");
+  Serial.println(armedStarts);
+}
+
+#endif
@@ -0,0 +1,441 @@
+#ifndef TABLES_H
+#define TABLES_H
+
+#include <string.h>
+#include <MD_YX5300.h>
+#include "buttons.h"
+#include "gates.h"
+#include "incremental.h"
+#include "leds.h"
+#include "recovery.h"
+#include "voting.h"
+
+// Several boards served by one controller. Every table owns its game state,
+// button, LEDs and MP3 player. The rule engine keeps working on the globals
+// (presentCards, boardState, ruleCache, currentLevel, ...), which hold the
+// state of the table being served: selectTable() swaps them. Cues are queued
+// as steps and played without blocking, so one table's audio never holds up
+// another table's scan.
+
+const int maxCueSteps = 48;
+
+const unsigned long trackTimeout = 180000;  // Longest track, a wait never lasts longer
+const unsigned long statusInterval = 1000; // Ask the player whether it is still playing
+const unsigned long statusGrace = 500;     // Time the player needs to start a track
+const unsigned long armStepMs = 30;        // Time the player needs per pre-arm command
+const byte playerVolume = 30;              // Power-on volume, the firmware never changes it
+
+// Game state of the table being served
+int currentLevel = 0; // Current level of the system
+bool introduction01 = true;
+bool introduction02 = false;
+
+enum TablePhase
+{
+  TABLE_IDLE,     // Waiting for the button
+  TABLE_SCAN,     // Reading one gate per slice
+  TABLE_CONFIRM,  // Reading doubtful empty gates again
+  TABLE_EVALUATE, // Admin keys and rules, queues the cues
+  TABLE_CUE       // Playing the queued cues
+};
+
+enum CueKind
+{
+  CUE_PLAY,     // value: folder << 8 | track
+  CUE_WAIT_END, // Wait for the end of the track
+  CUE_PAUSE,    // value: milliseconds
+  CUE_LED_ON,   // value: LED, allLeds for every LED
+  CUE_LED_OFF,
+  CUE_LED_EFFECT // led and effect, value: milliseconds after the last track started
+};
+
+const uint16_t allLeds = 0xFF;
+
+// Pre-arm of a player: muted, the track is selected and paused, then the
+// volume comes back, so the cue that plays the track only has to resume it
+enum ArmStep
+{
+  ARM_NONE,
+  ARM_MUTED,
+  ARM_SELECTED,
+  ARM_PAUSED,
+  ARM_READY
+};
+
+struct CueStep
+{
+  byte kind;
+  byte led; // CUE_LED_EFFECT: LED, allLeds for every LED
+  uint16_t value;
+  LedEffect effect;
+};
+
+// Button, LEDs and player of a table, the gate pins are listed in gates.h
+struct TableHardware
+{
+  int buttonPin;
+  const int *ledPins;          // numLeds pins
+  MD_YX5300 *player;
+  unsigned long latencyBudget; // Milliseconds from button press to verdict
+};
+
+struct Table
+{
+  TableHardware hw;
+
+  // Game state, swapped in by selectTable()
+  int level;
+  bool intro01;
+  bool intro02;
+  byte cards[numGatePins];
+  uint64_t board;
+  byte stable[numGatePins];
+  RuleCache cache;
+
+  // Work in progress
+  byte phase;
+  byte nextGate;          // Next gate to read in TABLE_SCAN
+  CueStep cues[maxCueSteps];
+  byte cueCount;
+  byte cueNext;           // Step being played
+  bool stepStarted;       // stepStart and lastQuery are valid for cueNext
+  unsigned long stepStart;
+  unsigned long lastQuery;
+  uint32_t trackStartUs;  // micros() when the cues last started a track
+
+  // Latency from button press to verdict
+  bool pressPending;
+  unsigned long pressedAt; // millis() at the press
+  uint32_t pressedUs;      // micros() at the press
+  unsigned long presses;
+  unsigned long lastLatency;
+  unsigned long maxLatency;
+  unsigned long budgetMisses;
+  unsigned long maxSliceUs; // Longest single step
+  unsigned long stageUs;    // Time spent in the current phase
+
+  // Speculation on background reads, see speculate.h
+  bool specValid;               // specOutcome is the verdict for specCards
+  byte specCards[numGatePins];
+  int specLevel;
+  Outcome specOutcome;
+  byte specGate;                // Next gate of the background sweep
+  unsigned long specUntil;      // millis() until which the board is watched
+  unsigned long specLast;       // millis() of the last background read
+  byte armStep;                 // ArmStep of the player
+  uint16_t armCue;              // CUE_PLAY value of the track being armed
+  uint16_t armWant;             // CUE_PLAY value to arm, 0 for none
+  unsigned long armAt;          // millis() of the last pre-arm command
+
+  byte ledsBefore[numLeds];     // LED levels before the scan feedback, see feedback.h
+};
+
+Table tables[numTables];
+Table *table = &tables[0]; // Table whose state is in the globals
+
+unsigned long armsReady = 0;   // Tracks pre-armed on a player
+unsigned long armedStarts = 0; // Cues that resumed a pre-armed track
+
+void storeTable(int t)
+{
+  Table &s = tables[t];
+  s.level = currentLevel;
+  s.intro01 = introduction01;
+  s.intro02 = introduction02;
+  memcpy(s.cards, presentCards, sizeof(s.cards));
+  s.board = boardState;
+  memcpy(s.stable, stableCards, sizeof(s.stable));
+  s.cache = ruleCache;
+}
+
+void loadTable(int t)
+{
+  Table &s = tables[t];
+  currentLevel = s.level;
+  introduction01 = s.intro01;
+  introduction02 = s.intro02;
+  memcpy(presentCards, s.cards, sizeof(s.cards));
+  boardState = s.board;
+  memcpy(stableCards, s.stable, sizeof(s.stable));
+  ruleCache = s.cache;
+  activeTable = t;
+  table = &s;
+}
+
+void selectTable(int t)
+{
+  if (t == activeTable)
+    return;
+  storeTable(activeTable);
+  loadTable(t);
+}
+
+void initTable(int t, const TableHardware &hw)
+{
+  Table &s = tables[t];
+  s.hw = hw;
+  s.level = 0;
+  s.intro01 = true;
+  s.intro02 = false;
+  s.cache.level = -1;
+  s.phase = TABLE_IDLE;
+
+  initLeds(t, hw.ledPins);
+  initButton(t, hw.buttonPin);
+}
+
+// Add a step to the cues of the active table
+void queueCue(byte kind, uint16_t value = 0)
+{
+  if (table->cueCount >= maxCueSteps)
+  {
+    Serial.println("Cue queue full, step dropped.");
+    return;
+  }
+  table->cues[table->cueCount++] = {kind, 0, value};
+}
+
+// Play an LED effect atMs after the start of the track queued before it, the
+// cues do not wait for the effect
+void queueEffect(uint16_t led, const LedEffect &effect, uint16_t atMs = 0)
+{
+  byte count = table->cueCount;
+  queueCue(CUE_LED_EFFECT, atMs);
+  if (table->cueCount > count)
+  {
+    table->cues[count].led = led;
+    table->cues[count].effect = effect;
+  }
+}
+
+void queueTrack(byte track, byte folder = 1)
+{
+  queueCue(CUE_PLAY, folder << 8 | track);
+  queueCue(CUE_WAIT_END);
+}
+
+void queueFlicker(int led, int times = 3, int duration = 500, bool leaveOn = true, uint16_t atMs = 0)
+{
+  LedEffect blink = {EFFECT_BLINK, 255, (uint16_t)(2 * duration), (byte)times, (byte)(leaveOn ? 255 : 0)};
+  queueEffect(led, blink, atMs);
+}
+
+void writeLeds(Table &t, uint16_t led, int value)
+{
+  int base = (&t - tables) * numLeds;
+  for (int i = 0; i < numLeds; i++)
+  {
+    if (led == allLeds || led == i)
+      setLed(base + i, value == HIGH ? 255 : 0);
+  }
+}
+
+void startEffects(Table &t, const CueStep &step)
+{
+  int base = (&t - tables) * numLeds;
+  for (int i = 0; i < numLeds; i++)
+  {
+    if (step.led == (byte)allLeds || step.led == i)
+      startEffect(base + i, step.effect, t.trackStartUs + step.value * 1000UL);
+  }
+}
+
+// Give up a pre-arm, the player is unmuted if it was cut short
+void cancelArm(Table &t)
+{
+  if (t.armStep != ARM_NONE && t.armStep != ARM_READY)
+    t.hw.player->volume(playerVolume);
+  t.armStep = ARM_NONE;
+  t.armWant = 0;
+}
+
+// Next pre-arm command for armWant, one per armStepMs
+void stepArm(Table &t)
+{
+  if (t.armWant == 0 || (t.armStep == ARM_READY && t.armCue == t.armWant))
+    return;
+  if (millis() - t.armAt < armStepMs)
+    return;
+
+  MD_YX5300 &player = *t.hw.player;
+  switch (t.armStep)
+  {
+  case ARM_NONE:
+  case ARM_READY:
+    player.volume(0);
+    t.armStep = ARM_MUTED;
+    break;
+
+  case ARM_MUTED:
+  case ARM_PAUSED:
+    if (t.armStep == ARM_PAUSED && t.armCue == t.armWant)
+    {
+      player.volume(playerVolume);
+      t.armStep = ARM_READY;
+      armsReady++;
+      break;
+    }
+    t.armCue = t.armWant;
+    player.playSpecific(t.armCue >> 8, t.armCue & 0xFF);
+    t.armStep = ARM_SELECTED;
+    break;
+
+  case ARM_SELECTED:
+    player.playPause();
+    t.armStep = ARM_PAUSED;
+    break;
+  }
+  t.armAt = millis();
+}
+
+// Poll the player for the end of the track. Gives up when the player reports
+// an error, is found stopped without reporting the end, or the deadline
+// passes, so a lost reply cannot hang the table.
+bool trackEnded(Table &t)
+{
+  MD_YX5300 &player = *t.hw.player;
+
+  if (player.check())
+  {
+    const MD_YX5300::cbData *status = player.getStatus();
+
+    if (status->code == MD_YX5300::STS_FILE_END)
+      return true;
+
+    if (status->code == MD_YX5300::STS_ERR_FILE)
+    {
+      recordRecovery(CAUSE_AUDIO_ERROR);
+      return true;
+    }
+
+    // Status reply 0 means stopped, allow the player time to start the track
+    if (status->code == MD_YX5300::STS_STATUS && (status->data & 0xFF) == 0 &&
+        millis() - t.stepStart >= statusGrace)
+    {
+      recordRecovery(CAUSE_MISSED_END);
+      return true;
+    }
+  }
+
+  if (millis() - t.stepStart >= trackTimeout)
+  {
+    recordRecovery(CAUSE_AUDIO_TIMEOUT);
+    return true;
+  }
+
+  if (millis() - t.lastQuery >= statusInterval)
+  {
+    player.queryStatus();
+    t.lastQuery = millis();
+  }
+  return false;
+}
+
+// Play the queued cues as far as possible without waiting, returns true once
+// every step is done
+bool runCues(Table &t)
+{
+  while (t.cueNext < t.cueCount)
+  {
+    const CueStep &step = t.cues[t.cueNext];
+
+    if (!t.stepStarted)
+    {
+      t.stepStarted = true;
+      t.stepStart = millis();
+      t.lastQuery = t.stepStart;
+    }
+
+    switch (step.kind)
+    {
+    case CUE_PLAY:
+      // Replies still queued from the scan acknowledgement or the pre-arm,
+      // a stale end of track would finish the wait for this one at once
+      while (t.hw.player->check())
+        ;
+      if (t.armStep == ARM_READY && t.armCue == step.value)
+      {
+        t.hw.player->playStart();
+        armedStarts++;
+        t.armStep = ARM_NONE;
+        t.armWant = 0;
+      }
+      else
+      {
+        cancelArm(t);
+        t.hw.player->playSpecific(step.value >> 8, step.value & 0xFF);
+      }
+      t.trackStartUs = micros();
+      break;
+
+    case CUE_WAIT_END:
+      setActivity(ACTIVITY_AUDIO);
+      if (!trackEnded(t))
+        return false;
+      break;
+
+    case CUE_PAUSE:
+      if (millis() - t.stepStart < step.value)
+        return false;
+      break;
+
+    case CUE_LED_ON:
+      writeLeds(t, step.value, HIGH);
+      break;
+
+    case CUE_LED_OFF:
+      writeLeds(t, step.value, LOW);
+      break;
+
+    case CUE_LED_EFFECT:
+      startEffects(t, step);
+      break;
+    }
+
+    t.stepStarted = false;
+    t.cueNext++;
+  }
+
+  t.cueCount = 0;
+  t.cueNext = 0;
+  return true;
+}
+
+// Record the time from the button press to the verdict of the active table,
+// returns it in microseconds
+unsigned long recordLatency()
+{
+  unsigned long latencyUs = micros() - table->pressedUs;
+  unsigned long latency = latencyUs / 1000;
+  table->lastLatency = latency;
+  if (latency > table->maxLatency)
+    table->maxLatency = latency;
+  if (latency > table->hw.latencyBudget)
+    table->budgetMisses++;
+  return latencyUs;
+}
+
+void printTableStats()
+{
+  for (int t = 0; t < numTables; t++)
+  {
+    const Table &s = tables[t];
+    Serial.print("Table ");
+    Serial.print(t + 1);
+    Serial.print(": phase ");
+    Serial.print(s.phase);
+    Serial.print(", presses ");
+    Serial.print(s.presses);
+    Serial.print(", latency last ");
+    Serial.print(s.lastLatency);
+    Serial.print(" ms, max ");
+    Serial.print(s.maxLatency);
+    Serial.print(" ms, over budget ");
+    Serial.print(s.budgetMisses);
+    Serial.print(", longest slice ");
+    Serial.print(s.maxSliceUs);
+    Serial.println(" us");
+  }
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef TAGDATA_H
+#define TAGDATA_H
+
+#include <MFRC522.h>
+
+// Category stored on the tile itself, in the last user page of an NTAG21x:
+// 'N', 'V', category and a CRC-8 over those three bytes and the UID, so data
+// copied to another tag is rejected. Tags without it fall back to the registry.
+
+const byte categoryPage = 0x27; // Last user page of an NTAG213, also present on NTAG215/216
+const byte categoryMagic0 = 'N';
+const byte categoryMagic1 = 'V';
+
+byte crc8(byte crc, byte data)
+{
+  crc ^= data;
+  for (int i = 0; i < 8; i++)
+  {
+    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+byte categoryChecksum(const MFRC522::Uid &uid, byte category)
+{
+  byte crc = 0;
+  crc = crc8(crc, categoryMagic0);
+  crc = crc8(crc, categoryMagic1);
+  crc = crc8(crc, category);
+  for (byte i = 0; i < uid.size; i++)
+  {
+    crc = crc8(crc, uid.uidByte[i]);
+  }
+  return crc;
+}
+
+// Category in the contents of categoryPage, 0 when it has none or it is invalid
+byte pageCategory(const byte *page, const MFRC522::Uid &uid)
+{
+  if (page[0] != categoryMagic0 || page[1] != categoryMagic1)
+    return 0;
+
+  if (page[3] != categoryChecksum(uid, page[2]))
+    return 0;
+
+  return page[2];
+}
+
+// Category stored on the selected tag, 0 when it has none or it is invalid
+byte readTagCategory(MFRC522 &reader)
+{
+  byte buffer[18]; // MIFARE_Read returns four pages plus the CRC
+  byte size = sizeof(buffer);
+
+  if (reader.MIFARE_Read(categoryPage, buffer, &size) != MFRC522::STATUS_OK)
+    return 0;
+
+  return pageCategory(buffer, reader.uid);
+}
+
+// Write a category to the selected tag and read it back
+bool writeTagCategory(MFRC522 &reader, byte category)
+{
+  byte page[4] = {categoryMagic0, categoryMagic1, category, categoryChecksum(reader.uid, category)};
+
+  if (reader.MIFARE_Ultralight_Write(categoryPage, page, sizeof(page)) != MFRC522::STATUS_OK)
+    return false;
+
+  return readTagCategory(reader) == category;
+}
+
+#endif
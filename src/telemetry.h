@@ -0,0 +1,170 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+// Binary telemetry, shared with tools/telemetry_agg. Events are framed as
+//   sync, sequence, type, length, payload, CRC-16 (low byte first)
+// with the CRC-16/CCITT-FALSE over sequence to payload. The sync byte never
+// occurs in text, so frames can share the USB serial port with the console
+// and the DEBUG output: a receiver skips everything that is not a valid frame.
+// Frames are queued in a ring and drained from loop() without blocking; a
+// frame that does not fit is dropped and shows up as a gap in the sequence.
+// Integers in payloads are little-endian. Off until TELEMETRY on, a terminal
+// would show the frames as garbage.
+
+const byte telemetrySync = 0xA5;
+const int telemetryHeader = 4;   // Sync, sequence, type, length
+const int telemetryTrailer = 2;  // CRC
+const int telemetryMaxPayload = 32;
+const int telemetryRingSize = 512; // Power of two
+
+enum TelemetryEvent
+{
+  EV_BOOT = 1, // u32 ms to first interaction, u16 watchdog resets, u8 tables
+  EV_SCAN,     // u8 table, u8 level, u8 category per gate (6), u8 recovered gates,
+               // u16 SPI transactions, u16 SPI bytes, u8 gates read by the library
+               // (older firmware: 6 or 11 bytes with a nibble per gate)
+  EV_TIMING,   // u8 table, u8 stage, u32 microseconds
+  EV_LEVEL,    // u8 table, u8 from, u8 to
+  EV_VERDICT,  // u8 table, u8 level, u8 branch, u8 track
+  EV_COUNTERS, // u32 uptime s, u16 audio timeouts, u16 audio errors, u16 recovered gates, u16 budget misses, u16 dropped frames
+  EV_HINT      // u8 table, u8 level, u8 distance, u8 action, u8 gate, u8 group
+};
+
+enum TelemetryStage
+{
+  STAGE_SCAN,     // Gate sweep
+  STAGE_CONFIRM,  // Extra reads of doubtful gates
+  STAGE_EVALUATE, // Admin keys and rules
+  STAGE_LATENCY,  // Button press to verdict
+  STAGE_COUNT
+};
+
+bool TELEMETRY = false; // Send telemetry frames on the USB serial port, TELEMETRY on
+
+byte telemetryRing[telemetryRingSize];
+uint16_t telemetryHead = 0; // Next byte to write
+uint16_t telemetryTail = 0; // Next byte to send
+uint16_t telemetryFrameLeft = 0; // Bytes of the frame being sent, 0 between frames
+byte telemetrySequence = 0;
+uint16_t droppedFrames = 0;
+
+uint16_t crc16(uint16_t crc, byte data)
+{
+  crc ^= (uint16_t)data << 8;
+  for (int i = 0; i < 8; i++)
+  {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+int telemetryQueued()
+{
+  return (telemetryHead - telemetryTail) & (telemetryRingSize - 1);
+}
+
+// Queue one frame, the payload is copied
+void sendTelemetry(byte type, const byte *payload, byte length)
+{
+  if (!TELEMETRY)
+    return;
+
+  int frameSize = telemetryHeader + length + telemetryTrailer;
+  if (length > telemetryMaxPayload || telemetryQueued() + frameSize >= telemetryRingSize)
+  {
+    droppedFrames++;
+    telemetrySequence++;
+    return;
+  }
+
+  uint16_t crc = 0xFFFF;
+  byte header[telemetryHeader] = {telemetrySync, telemetrySequence++, type, length};
+  uint16_t head = telemetryHead;
+
+  for (int i = 0; i < telemetryHeader; i++)
+  {
+    if (i > 0)
+      crc = crc16(crc, header[i]);
+    telemetryRing[head] = header[i];
+    head = (head + 1) & (telemetryRingSize - 1);
+  }
+  for (int i = 0; i < length; i++)
+  {
+    crc = crc16(crc, payload[i]);
+    telemetryRing[head] = payload[i];
+    head = (head + 1) & (telemetryRingSize - 1);
+  }
+  telemetryRing[head] = crc & 0xFF;
+  head = (head + 1) & (telemetryRingSize - 1);
+  telemetryRing[head] = crc >> 8;
+  telemetryHead = (head + 1) & (telemetryRingSize - 1);
+}
+
+// Little-endian writers for payloads
+byte *put16(byte *p, uint16_t value)
+{
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+  return p + 2;
+}
+
+byte *put32(byte *p, uint32_t value)
+{
+  p = put16(p, value & 0xFFFF);
+  return put16(p, value >> 16);
+}
+
+void sendBoot(uint32_t readyMs, uint16_t resets, byte tables)
+{
+  byte payload[7];
+  byte *p = put32(payload, readyMs);
+  p = put16(p, resets);
+  *p = tables;
+  sendTelemetry(EV_BOOT, payload, sizeof(payload));
+}
+
+void sendTiming(byte table, byte stage, uint32_t us)
+{
+  byte payload[6] = {table, stage};
+  put32(payload + 2, us);
+  sendTelemetry(EV_TIMING, payload, sizeof(payload));
+}
+
+void sendLevel(byte table, byte from, byte to)
+{
+  byte payload[3] = {table, from, to};
+  sendTelemetry(EV_LEVEL, payload, sizeof(payload));
+}
+
+void sendVerdict(byte table, byte level, byte branch, byte track)
+{
+  byte payload[4] = {table, level, branch, track};
+  sendTelemetry(EV_VERDICT, payload, sizeof(payload));
+}
+
+void sendHint(byte table, byte level, byte distance, byte action, byte gate, byte group)
+{
+  byte payload[6] = {table, level, distance, action, gate, group};
+  sendTelemetry(EV_HINT, payload, sizeof(payload));
+}
+
+// One byte per gate, admin keys and unknown tags do not fit a nibble. Bus
+// counts saturate at 65535.
+void sendScan(byte table, byte level, const byte *cards, int gates, byte recovered,
+              uint32_t transactions, uint32_t bytes, byte libraryGates)
+{
+  byte payload[14] = {table, level};
+  for (int i = 0; i < gates && i < 6; i++)
+  {
+    payload[2 + i] = cards[i];
+  }
+  payload[8] = recovered;
+  byte *p = put16(payload + 9, transactions < 0xFFFF ? transactions : 0xFFFF);
+  p = put16(p, bytes < 0xFFFF ? bytes : 0xFFFF);
+  *p = libraryGates;
+  sendTelemetry(EV_SCAN, payload, sizeof(payload));
+}
+
+#endif
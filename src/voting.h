@@ -0,0 +1,88 @@
+#ifndef VOTING_H
+#define VOTING_H
+
+#include "rules.h"
+
+// Confirmation filter for flaky reads. A UID read is CRC-checked, so a read
+// that returns a card is trusted, but a failed read looks exactly like an
+// empty gate. After the sweep only the doubtful empty gates are read again:
+// gates that held a card at the previous scan, and every empty gate when the
+// board matches no connection mask. Any card seen in the extra reads wins.
+
+const int maxConfirmReads = 2; // Extra reads per disputed gate
+
+enum GateDecision
+{
+  GATE_READ,            // First read accepted
+  GATE_CONFIRMED_EMPTY, // Disputed, still empty after the extra reads
+  GATE_RECOVERED        // Disputed, a card was found by an extra read
+};
+
+byte stableCards[numGatePins];   // Board after the previous confirmation
+byte gateDecision[numGatePins];  // Decision per gate of the last scan
+unsigned long disputedGates = 0; // Gates read again
+unsigned long confirmReads = 0;  // Extra reads done
+unsigned long recoveredGates = 0; // Cards found by an extra read
+unsigned long flakyReads[numGatePins]; // Recovered gates per gate
+
+// Read disputed gates again, readGate() returns the category read on a gate
+void confirmBoard(byte (*readGate)(int))
+{
+  bool topologyValid = matchConnectionMasks();
+
+  for (int gate = 0; gate < numGatePins; gate++)
+  {
+    gateDecision[gate] = GATE_READ;
+
+    if (presentCards[gate] != 0)
+      continue;
+    if (stableCards[gate] == 0 && topologyValid)
+      continue;
+
+    disputedGates++;
+    gateDecision[gate] = GATE_CONFIRMED_EMPTY;
+    for (int attempt = 0; attempt < maxConfirmReads; attempt++)
+    {
+      confirmReads++;
+      byte category = readGate(gate);
+      if (category != 0)
+      {
+        setGateCard(gate, category);
+        gateDecision[gate] = GATE_RECOVERED;
+        recoveredGates++;
+        flakyReads[gate]++;
+        break;
+      }
+    }
+  }
+
+  for (int gate = 0; gate < numGatePins; gate++)
+  {
+    stableCards[gate] = presentCards[gate];
+  }
+}
+
+void printVotingStats()
+{
+  Serial.print("Confirmation: decisions");
+  for (int gate = 0; gate < numGatePins; gate++)
+  {
+    Serial.print(" ");
+    Serial.print(gateDecision[gate]);
+  }
+  Serial.print(", disputed ");
+  Serial.print(disputedGates);
+  Serial.print(", extra reads ");
+  Serial.print(confirmReads);
+  Serial.print(", recovered ");
+  Serial.print(recoveredGates);
+  Serial.print(", flaky per gate");
+  for (int gate = 0; gate < numGatePins; gate++)
+  {
+    Serial.print(" ");
+    Serial.print(flakyReads[gate]);
+  }
+  Serial.println();
+}
+
+#endif
@@ -0,0 +1,503 @@
+// Microbenchmarks for the hot kernels of the firmware, run on the host.
+//
+// Covers the UID lookup of checkReader() (the built-in registry and
+// generated registries of up to 10k tags), matchConnectionMasks(),
+// hasIllegalComponents(), the boardState rebuild in countCards(), the rule
+// chain of every level, the decision table and the incremental evaluator.
+// Every kernel runs on realistic inputs (boards the game produces, tags that
+// are registered) and on adversarial ones that take the longest path (boards
+// matching no mask, full boards of allowed components, boards no rule
+// decides, UIDs that miss in the second search).
+//
+// Build and run on the host from the repository root:
+//   g++ -O2 -std=c++17 -I src tools/bench/bench.cpp -o bench
+//   ./bench [--out results.json] [--baseline tools/bench/baseline.json] [--tolerance 0.25]
+//
+// Results go to a JSON file in nanoseconds per call, the best of several
+// samples. With a baseline every kernel is compared against it and the exit
+// code is non-zero when one got slower by more than the tolerance. The
+// baseline in the tree was recorded with the build line above; record a new
+// one on the machine that runs the comparison (--out to the baseline file).
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef uint8_t byte;
+#include "decision.h"
+#include "incremental.h"
+#include "registry.h"
+
+const int inputCount = 4096;        // Inputs per kernel, cycled through
+const int samples = 7;              // Timed samples per kernel, the best counts
+const double sampleSeconds = 0.02;  // Length of one sample
+const double noiseFloorNs = 1.0;    // Smaller changes are never regressions
+
+static uint32_t rngState = 0x12345678;
+
+static uint32_t rng()
+{
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+static int rngBelow(int n)
+{
+  return rng() % n;
+}
+
+// Board with its packed state, loaded by the kernels before each call
+struct Board
+{
+  byte cards[numGatePins];
+  uint64_t state;
+};
+
+static Board makeBoard(const byte *cards)
+{
+  Board b;
+  memcpy(presentCards, cards, numGatePins);
+  countCards();
+  memcpy(b.cards, presentCards, numGatePins);
+  b.state = boardState;
+  return b;
+}
+
+static inline void loadBoard(const Board &b)
+{
+  memcpy(presentCards, b.cards, numGatePins);
+  boardState = b.state;
+}
+
+static bool occupancyMatches(int occupancy)
+{
+  for (int i = 0; i < connectionMasksCount; i++)
+  {
+    int mask = 0;
+    for (int j = 0; j < numGatePins; j++)
+      mask |= connectionMasks[i][j] << j;
+    if (mask == occupancy)
+      return true;
+  }
+  return false;
+}
+
+// Occupancy of a connection mask with categories the level allows
+static Board realisticBoard(int level)
+{
+  const uint8_t *mask = connectionMasks[rngBelow(connectionMasksCount)];
+  byte cards[numGatePins];
+  for (int j = 0; j < numGatePins; j++)
+    cards[j] = mask[j] ? allowedComponents[level][rngBelow(allowedComponentsCount[level])] : 0;
+  return makeBoard(cards);
+}
+
+// Any occupancy, any category
+static Board randomBoard()
+{
+  byte cards[numGatePins];
+  for (int j = 0; j < numGatePins; j++)
+    cards[j] = rngBelow(14);
+  return makeBoard(cards);
+}
+
+// Occupancy that matches no connection mask, every mask is tried
+static Board unmatchedBoard()
+{
+  while (true)
+  {
+    int occupancy = rngBelow(1 << numGatePins);
+    if (occupancyMatches(occupancy))
+      continue;
+    byte cards[numGatePins];
+    for (int j = 0; j < numGatePins; j++)
+      cards[j] = (occupancy >> j) & 1 ? 1 + rngBelow(13) : 0;
+    return makeBoard(cards);
+  }
+}
+
+// Every gate holds the last allowed category, the longest scan of the list
+static Board fullAllowedBoard(int level)
+{
+  byte cards[numGatePins];
+  for (int j = 0; j < numGatePins; j++)
+    cards[j] = allowedComponents[level][allowedComponentsCount[level] - 1 - rngBelow(2)];
+  return makeBoard(cards);
+}
+
+// Legal boards that no rule decides, the whole chain runs. Empty when the
+// level always decides within the attempts.
+static std::vector<Board> fallbackBoards(int level)
+{
+  std::vector<Board> pool;
+  for (int attempt = 0; attempt < 200000 && pool.size() < 64; attempt++)
+  {
+    byte cards[numGatePins];
+    for (int j = 0; j < numGatePins; j++)
+      cards[j] = rngBelow(3) ? allowedComponents[level][rngBelow(allowedComponentsCount[level])] : 0;
+    Board b = makeBoard(cards);
+    if (evaluateRules(level) == BRANCH_FALLBACK)
+      pool.push_back(b);
+  }
+
+  std::vector<Board> v;
+  for (int i = 0; !pool.empty() && i < inputCount; i++)
+    v.push_back(pool[i % pool.size()]);
+  return v;
+}
+
+struct Kernel
+{
+  std::string name;
+  double ns;
+};
+
+static std::vector<Kernel> results;
+static volatile uint32_t sink;
+
+// Time fn(i) over the inputs, fn returns something to keep the call alive
+template <typename F>
+static void bench(const std::string &name, F fn)
+{
+  using clock = std::chrono::steady_clock;
+
+  // Calibrate the calls per sample
+  long calls = inputCount;
+  while (true)
+  {
+    auto start = clock::now();
+    uint32_t acc = 0;
+    for (long i = 0; i < calls; i++)
+      acc += fn(i & (inputCount - 1));
+    sink = acc;
+    double seconds = std::chrono::duration<double>(clock::now() - start).count();
+    if (seconds >= sampleSeconds / 4)
+    {
+      calls = (long)(calls * sampleSeconds / seconds) + 1;
+      break;
+    }
+    calls *= 4;
+  }
+
+  double best = 1e30;
+  for (int s = 0; s < samples; s++)
+  {
+    auto start = clock::now();
+    uint32_t acc = 0;
+    for (long i = 0; i < calls; i++)
+      acc += fn(i & (inputCount - 1));
+    sink = acc;
+    double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / calls;
+    if (ns < best)
+      best = ns;
+  }
+  results.push_back({name, best});
+  printf("  %-36s %9.2f ns\n", name.c_str(), best);
+  fflush(stdout);
+}
+
+static std::vector<Board> boards(Board (*make)())
+{
+  std::vector<Board> v(inputCount);
+  for (Board &b : v)
+    b = make();
+  return v;
+}
+
+static std::vector<Board> boards(Board (*make)(int), int level)
+{
+  std::vector<Board> v(inputCount);
+  for (Board &b : v)
+    b = make(level);
+  return v;
+}
+
+// UIDs to look up: registered ones, unknown suffixes, and known suffixes
+// with unknown tags, which run both binary searches to the end
+struct Uid
+{
+  byte uid[7];
+};
+
+template <int N>
+static void lookupInputs(const TagEntry (&tags)[N], std::vector<Uid> &hits, std::vector<Uid> &suffixMisses,
+                         std::vector<Uid> &tagMisses, bool (*registeredUid)(const byte *))
+{
+  hits.resize(inputCount);
+  suffixMisses.resize(inputCount);
+  tagMisses.resize(inputCount);
+  for (int i = 0; i < inputCount; i++)
+  {
+    memcpy(hits[i].uid, tags[rngBelow(N)].uid, 7);
+
+    Uid &s = suffixMisses[i];
+    memcpy(s.uid, tags[rngBelow(N)].uid, 7);
+    s.uid[0] = 0x88; // Not an NXP UID
+    s.uid[6] ^= 0x5A;
+
+    Uid &t = tagMisses[i];
+    do
+    {
+      memcpy(t.uid, tags[rngBelow(N)].uid, 7);
+      t.uid[1] = rng();
+      t.uid[2] = rng();
+    } while (registeredUid(t.uid));
+  }
+}
+
+static bool inBuiltin(const byte *uid)
+{
+  return lookupCategory(uid) != 0;
+}
+
+static void benchBuiltinLookup()
+{
+  std::vector<Uid> hits, suffixMisses, tagMisses;
+  lookupInputs(registered, hits, suffixMisses, tagMisses, inBuiltin);
+
+  char name[64];
+  snprintf(name, sizeof(name), "lookup/builtin%d/hit", registeredCount);
+  bench(name, [&](int i) { return lookupCategory(hits[i].uid); });
+  snprintf(name, sizeof(name), "lookup/builtin%d/suffix_miss", registeredCount);
+  bench(name, [&](int i) { return lookupCategory(suffixMisses[i].uid); });
+  snprintf(name, sizeof(name), "lookup/builtin%d/tag_miss", registeredCount);
+  bench(name, [&](int i) { return lookupCategory(tagMisses[i].uid); });
+}
+
+// Registry of N tags over D batch suffixes, packed like the built-in one
+template <int N, int D>
+struct Generated
+{
+  TagEntry tags[N];
+  SortedTags<N> sorted;
+  PackedRegistry<N, D> packed;
+};
+
+template <int N, int D>
+static void benchGeneratedLookup(const char *label)
+{
+  static Generated<N, D> g;
+
+  for (int i = 0; i < N; i++)
+  {
+    int suffix = i % D; // Every suffix is used
+    byte *uid = g.tags[i].uid;
+    uid[0] = 0x04;
+    uid[1] = (i / D) >> 8;
+    uid[2] = (i / D) & 0xFF;
+    uid[3] = 0x2A + (suffix >> 8);
+    uid[4] = suffix & 0xFF;
+    uid[5] = 0x2A;
+    uid[6] = 0x81;
+    g.tags[i].category = 1 + i % 13;
+  }
+  g.sorted = sortTags(g.tags);
+  if (countSuffixes(g.sorted) != D)
+  {
+    fprintf(stderr, "%s: %d suffixes, expected %d\n", label, countSuffixes(g.sorted), D);
+    exit(2);
+  }
+  g.packed = packRegistry<N, D>(g.sorted);
+
+  static Generated<N, D> *current;
+  current = &g;
+  std::vector<Uid> hits, suffixMisses, tagMisses;
+  lookupInputs(g.tags, hits, suffixMisses, tagMisses,
+               [](const byte *uid) { return lookupTag(current->packed, uid) != 0; });
+
+  std::string base = std::string("lookup/") + label;
+  bench(base + "/hit", [&](int i) { return lookupTag(g.packed, hits[i].uid); });
+  bench(base + "/suffix_miss", [&](int i) { return lookupTag(g.packed, suffixMisses[i].uid); });
+  bench(base + "/tag_miss", [&](int i) { return lookupTag(g.packed, tagMisses[i].uid); });
+}
+
+static void benchTopology()
+{
+  std::vector<Board> realistic = boards(realisticBoard, numLevels - 1);
+  std::vector<Board> random = boards(randomBoard);
+  std::vector<Board> unmatched = boards(unmatchedBoard);
+
+  bench("masks/realistic", [&](int i) { loadBoard(realistic[i]); return (uint32_t)matchConnectionMasks(); });
+  bench("masks/random", [&](int i) { loadBoard(random[i]); return (uint32_t)matchConnectionMasks(); });
+  bench("masks/unmatched", [&](int i) { loadBoard(unmatched[i]); return (uint32_t)matchConnectionMasks(); });
+
+  bench("illegal/random", [&](int i) { loadBoard(random[i]); return (uint32_t)hasIllegalComponents(i % numLevels); });
+  for (int level = 0; level < numLevels; level++)
+  {
+    std::vector<Board> full = boards(fullAllowedBoard, level);
+    bench("illegal/level" + std::to_string(level) + "/full_allowed",
+          [&](int i) { loadBoard(full[i]); return (uint32_t)hasIllegalComponents(level); });
+  }
+
+  // Full rebuild of boardState from presentCards, as after a direct write
+  bench("count_cards/random", [&](int i) {
+    memcpy(presentCards, random[i].cards, numGatePins);
+    countCards();
+    return (uint32_t)boardState;
+  });
+  bench("count_cards/full", [&](int i) {
+    memcpy(presentCards, realistic[i].cards, numGatePins);
+    presentCards[i % numGatePins] = PHOTODIODE;
+    countCards();
+    return (uint32_t)boardState;
+  });
+}
+
+static void benchRules()
+{
+  for (int level = 0; level < numLevels; level++)
+  {
+    std::string base = "rules/level" + std::to_string(level);
+    std::vector<Board> realistic = boards(realisticBoard, level);
+    std::vector<Board> fallback = fallbackBoards(level);
+
+    bench(base + "/realistic", [&](int i) { loadBoard(realistic[i]); return (uint32_t)evaluateRules(level); });
+    if (!fallback.empty())
+      bench(base + "/fallback", [&](int i) { loadBoard(fallback[i]); return (uint32_t)evaluateRules(level); });
+  }
+}
+
+// The whole verdict of a press, the three ways the firmware gets it
+static void benchVerdicts()
+{
+  std::vector<Board> random = boards(randomBoard);
+  std::vector<Board> realistic = boards(realisticBoard, numLevels - 1);
+
+  bench("verdict/evaluate_board", [&](int i) { loadBoard(realistic[i]); return (uint32_t)evaluateBoard(i % numLevels).track; });
+  bench("verdict/decision_table", [&](int i) { loadBoard(realistic[i]); return (uint32_t)lookupOutcome(i % numLevels).track; });
+  bench("verdict/decision_table_random", [&](int i) { loadBoard(random[i]); return (uint32_t)lookupOutcome(i % numLevels).track; });
+
+  // Players change one tile between presses
+  std::vector<Board> steps(inputCount);
+  byte cards[numGatePins];
+  memcpy(cards, realistic[0].cards, numGatePins);
+  for (int i = 0; i < inputCount; i++)
+  {
+    cards[rngBelow(numGatePins)] = rngBelow(14);
+    steps[i] = makeBoard(cards);
+  }
+  ruleCache.level = -1;
+  bench("verdict/incremental_one_tile", [&](int i) { loadBoard(steps[i]); return (uint32_t)evaluateIncremental(numLevels - 1).track; });
+  ruleCache.level = -1;
+  bench("verdict/incremental_same_board", [&](int) { loadBoard(steps[0]); return (uint32_t)evaluateIncremental(numLevels - 1).track; });
+}
+
+static bool writeResults(const char *path)
+{
+  FILE *f = fopen(path, "w");
+  if (f == nullptr)
+  {
+    perror(path);
+    return false;
+  }
+  fprintf(f, "{\n  \"unit\": \"ns\",\n  \"kernels\": {\n");
+  for (size_t i = 0; i < results.size(); i++)
+    fprintf(f, "    \"%s\": %.2f%s\n", results[i].name.c_str(), results[i].ns, i + 1 < results.size() ? "," : "");
+  fprintf(f, "  }\n}\n");
+  fclose(f);
+  return true;
+}
+
+// Reads the kernels of a file written by writeResults(), one per line
+static bool readBaseline(const char *path, std::map<std::string, double> &baseline)
+{
+  FILE *f = fopen(path, "r");
+  if (f == nullptr)
+  {
+    perror(path);
+    return false;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), f))
+  {
+    char name[128];
+    double ns;
+    if (sscanf(line, " \"%127[^\"]\": %lf", name, &ns) == 2)
+      baseline[name] = ns;
+  }
+  fclose(f);
+  return true;
+}
+
+// Returns the number of regressions
+static int compare(const std::map<std::string, double> &baseline, double tolerance)
+{
+  int regressions = 0;
+  printf("\n%-36s %9s %9s %8s\n", "kernel", "ns", "baseline", "change");
+  for (const Kernel &k : results)
+  {
+    auto it = baseline.find(k.name);
+    if (it == baseline.end())
+    {
+      printf("%-36s %9.2f %9s %8s\n", k.name.c_str(), k.ns, "-", "new");
+      continue;
+    }
+    double change = k.ns / it->second - 1;
+    bool regressed = change > tolerance && k.ns - it->second > noiseFloorNs;
+    regressions += regressed;
+    printf("%-36s %9.2f %9.2f %+7.1f%%%s\n", k.name.c_str(), k.ns, it->second, change * 100,
+           regressed ? "  REGRESSION" : "");
+  }
+  printf("\n%d of %zu kernels slower than the baseline by more than %.0f%%\n", regressions, results.size(),
+         tolerance * 100);
+  return regressions;
+}
+
+int main(int argc, char **argv)
+{
+  const char *out = "bench.json";
+  const char *baselinePath = nullptr;
+  double tolerance = 0.25;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+      out = argv[++i];
+    else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+      baselinePath = argv[++i];
+    else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+      tolerance = atof(argv[++i]);
+    else
+    {
+      fprintf(stderr, "usage: %s [--out results.json] [--baseline file] [--tolerance fraction]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  std::map<std::string, double> baseline;
+  if (baselinePath != nullptr && !readBaseline(baselinePath, baseline))
+    return 2;
+
+  if (!checkDecisionTable())
+  {
+    fprintf(stderr, "src/decision_table.h is out of date, rerun tools/gen_decision_table\n");
+    return 2;
+  }
+
+  printf("Lookup\n");
+  benchBuiltinLookup();
+  benchGeneratedLookup<1000, 16>("gen1k");
+  benchGeneratedLookup<10000, 64>("gen10k");
+  benchGeneratedLookup<10000, 256>("gen10k_256suffixes");
+  printf("Topology\n");
+  benchTopology();
+  printf("Rules\n");
+  benchRules();
+  printf("Verdicts\n");
+  benchVerdicts();
+
+  if (!writeResults(out))
+    return 2;
+  printf("\nResults written to %s\n", out);
+
+  if (baselinePath != nullptr && compare(baseline, tolerance) > 0)
+    return 1;
+  return 0;
+}
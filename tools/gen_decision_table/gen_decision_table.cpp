@@ -0,0 +1,233 @@
+// Generates src/decision_table.h from the rule set in src/rules.h.
+//
+// The outcome of a button press only depends on the level, the occupied
+// gates and how many cards of each group lie on the board. The generator
+// evaluates the rule chain once per level and group histogram, checks the
+// table against evaluateBoard() for every possible board and writes it as
+// a header, together with the histograms that complete each level for the
+// hint engine in src/hints.h. Run it after every rule change, the PlatformIO build does so
+// through generate.py when rules.h, lvl.h or UID.h is newer than the table.
+//
+// Build and run on the host from the repository root:
+//   g++ -O2 -std=c++17 -I src tools/gen_decision_table/gen_decision_table.cpp -o gen_decision_table
+//   ./gen_decision_table src/decision_table.h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint8_t byte;
+#include "rules.h"
+
+const int tableBytes = (numHistograms + 1) / 2;
+
+static byte branches[numLevels][numHistograms];
+static bool ranked[numHistograms];
+static uint32_t packedCounts[numHistograms]; // Group counts, 3 bits per group
+static uint64_t validOccupancy;
+
+static int fillHistograms(int group, int gate)
+{
+  if (group == GROUP_COUNT)
+  {
+    for (int i = gate; i < numGatePins; i++)
+    {
+      presentCards[i] = 0;
+    }
+    countCards();
+
+    int rank = boardRank();
+    if (rank < 0 || rank >= numHistograms || ranked[rank])
+    {
+      printf("error: histogram rank %d is out of range or used twice\n", rank);
+      return 1;
+    }
+    ranked[rank] = true;
+    for (int g = 0; g < GROUP_COUNT; g++)
+    {
+      packedCounts[rank] |= (uint32_t)groupTotal(g) << (3 * g);
+    }
+
+    for (int level = 0; level < numLevels; level++)
+    {
+      branches[level][rank] = evaluateRules(level);
+    }
+    return 0;
+  }
+
+  int errors = 0;
+  for (int count = 0; gate + count <= numGatePins; count++)
+  {
+    for (int i = 0; i < count; i++)
+    {
+      presentCards[gate + i] = groupCategory[group];
+    }
+    errors += fillHistograms(group + 1, gate + count);
+  }
+  return errors;
+}
+
+// Values a gate takes in the check: empty, the 13 counted categories, and
+// an unknown category and an admin key, which lookupOutcome() hands to the
+// rules because the histogram does not count them
+static const byte gateValues[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, ADMIN_KEY_A};
+static const int numGateValues = sizeof(gateValues) / sizeof(gateValues[0]);
+
+// Compare the lookup of lookupOutcome() with evaluateBoard() for every
+// board at every level
+static long checkAllBoards()
+{
+  long boards = 1;
+  for (int i = 0; i < numGatePins; i++)
+  {
+    boards *= numGateValues;
+  }
+
+  long mismatches = 0;
+  for (long b = 0; b < boards; b++)
+  {
+    long index = b;
+    for (int i = 0; i < numGatePins; i++)
+    {
+      presentCards[i] = gateValues[index % numGateValues];
+      index /= numGateValues;
+    }
+    countCards();
+
+    bool valid = (validOccupancy >> occupancyMask()) & 1;
+    bool counted = boardCounted();
+    int rank = boardRank();
+    for (int level = 0; level < numLevels; level++)
+    {
+      int branch = !valid ? (int)BRANCH_MASK : counted ? (int)branches[level][rank] : (int)evaluateBoard(level).branch;
+      if (branch != evaluateBoard(level).branch && mismatches++ < 10)
+      {
+        printf("error: level %d board %ld, table branch %d, rules branch %d\n",
+               level, b, branch, evaluateBoard(level).branch);
+      }
+    }
+  }
+  return mismatches;
+}
+
+static int winningCount()
+{
+  int count = 0;
+  for (int level = 0; level < numLevels; level++)
+  {
+    for (int rank = 0; rank < numHistograms; rank++)
+    {
+      if (branches[level][rank] == BRANCH_RULE_0)
+        count++;
+    }
+  }
+  return count;
+}
+
+static int flashBytes()
+{
+  return numLevels * tableBytes + (int)sizeof(validOccupancy) +
+         winningCount() * (int)sizeof(uint32_t) + (numLevels + 1) * (int)sizeof(uint16_t);
+}
+
+static void writeWinning(FILE *out)
+{
+  fprintf(out, "// Group counts of every histogram that completes a level, 3 bits per group\n");
+  fprintf(out, "// with group 0 lowest. Level n owns winningHistograms[winningStart[n]] up to\n");
+  fprintf(out, "// winningStart[n + 1].\n");
+  fprintf(out, "const uint32_t winningHistograms[%d] = {", winningCount());
+
+  int start[numLevels + 1];
+  int written = 0;
+  for (int level = 0; level < numLevels; level++)
+  {
+    start[level] = written;
+    for (int rank = 0; rank < numHistograms; rank++)
+    {
+      if (branches[level][rank] != BRANCH_RULE_0)
+        continue;
+      if (written % 8 == 0)
+        fprintf(out, "\n    ");
+      fprintf(out, "0x%06X,", packedCounts[rank]);
+      written++;
+    }
+  }
+  start[numLevels] = written;
+  fprintf(out, "\n};\n\n");
+
+  fprintf(out, "const uint16_t winningStart[%d] = {", numLevels + 1);
+  for (int level = 0; level <= numLevels; level++)
+  {
+    fprintf(out, "%d%s", start[level], level < numLevels ? ", " : "};\n\n");
+  }
+}
+
+static void writeHeader(FILE *out)
+{
+
+  fprintf(out, "// Generated by tools/gen_decision_table from src/rules.h, do not edit.\n");
+  fprintf(out, "#ifndef DECISION_TABLE_H\n#define DECISION_TABLE_H\n\n");
+  fprintf(out, "#pragma message(\"Decision table: %d bytes of flash\")\n\n", flashBytes());
+  fprintf(out, "static_assert(numHistograms == %d, \"Decision table is out of date, run tools/gen_decision_table\");\n\n",
+          numHistograms);
+  fprintf(out, "// Bit n is set when occupancy mask n matches a connection mask\n");
+  fprintf(out, "const uint64_t validOccupancy = 0x%016llXULL;\n\n", (unsigned long long)validOccupancy);
+  fprintf(out, "// Branch per level and boardRank(), two ranks per byte, even rank in the low nibble\n");
+  fprintf(out, "const byte decisionTable[%d][%d] = {\n", numLevels, tableBytes);
+
+  for (int level = 0; level < numLevels; level++)
+  {
+    fprintf(out, "    {");
+    for (int i = 0; i < tableBytes; i++)
+    {
+      int low = branches[level][2 * i];
+      int high = 2 * i + 1 < numHistograms ? branches[level][2 * i + 1] : 0;
+      if (i % 16 == 0)
+        fprintf(out, "\n        ");
+      fprintf(out, "0x%02X,", (high << 4) | low);
+    }
+    fprintf(out, "\n    },\n");
+  }
+  fprintf(out, "};\n\n");
+
+  writeWinning(out);
+  fprintf(out, "#endif\n");
+}
+
+int main(int argc, char **argv)
+{
+  const char *path = argc > 1 ? argv[1] : "src/decision_table.h";
+
+  for (int mask = 0; mask < 64; mask++)
+  {
+    for (int i = 0; i < numGatePins; i++)
+    {
+      presentCards[i] = (mask >> i) & 1 ? LINE_STRAIGHT : 0;
+    }
+    if (matchConnectionMasks())
+      validOccupancy |= 1ULL << mask;
+  }
+
+  if (fillHistograms(0, 0) > 0)
+    return 1;
+
+  long mismatches = checkAllBoards();
+  if (mismatches > 0)
+  {
+    printf("%ld boards disagree with the rules, categories in a group are not treated alike\n", mismatches);
+    return 1;
+  }
+
+  FILE *out = fopen(path, "w");
+  if (!out)
+  {
+    perror(path);
+    return 1;
+  }
+  writeHeader(out);
+  fclose(out);
+
+  printf("Wrote %s: %d histograms, %d winning, %d bytes of flash\n", path, numHistograms,
+         winningCount(), flashBytes());
+  return 0;
+}
@@ -0,0 +1,31 @@
+# PlatformIO pre-build script: regenerate src/decision_table.h when the rule
+# sources are newer than the table. Needs a host C++ compiler; without one the
+# committed table is used and the firmware checks it against the rules at boot.
+Import("env")
+
+import os
+import shutil
+import subprocess
+
+project_dir = env.subst("$PROJECT_DIR")
+src_dir = os.path.join(project_dir, "src")
+table = os.path.join(src_dir, "decision_table.h")
+generator_src = os.path.join(project_dir, "tools", "gen_decision_table", "gen_decision_table.cpp")
+sources = [os.path.join(src_dir, name) for name in ("rules.h", "lvl.h", "UID.h")] + [generator_src]
+
+
+def needs_update():
+    if not os.path.exists(table):
+        return True
+    table_time = os.path.getmtime(table)
+    return any(os.path.getmtime(path) > table_time for path in sources)
+
+
+if needs_update():
+    compiler = shutil.which("g++") or shutil.which("clang++")
+    if compiler is None:
+        print("Decision table: no host C++ compiler found, keeping the committed table")
+    else:
+        generator = os.path.join(env.subst("$PROJECT_BUILD_DIR"), "gen_decision_table")
+        subprocess.check_call([compiler, "-O2", "-std=c++17", "-I", src_dir, generator_src, "-o", generator])
+        subprocess.check_call([generator, table])
@@ -0,0 +1,439 @@
+// Compiler for level packs (src/levelpack.h).
+//
+// Reads a text description of the levels (see levels.txt, which describes the
+// built-in levels), checks it and writes the binary pack. The pack is then
+// checked the way the firmware does before it stores one, and evaluated for
+// every occupancy and group histogram: the report lists how many boards each
+// rule decides per level, rules that never decide, and how many outcomes
+// differ from the built-in levels in src/rules.h.
+//
+// Build and run on the host from the repository root:
+//   g++ -O2 -std=c++17 -I src tools/level_pack/level_pack.cpp -o level_pack
+//   ./level_pack tools/level_pack/levels.txt -o levels.bin [--upload /dev/ttyACM0]
+//
+// --upload sends the pack with the PACK console command and prints the reply.
+// The exit code is non-zero when the description or the pack has an error.
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+typedef uint8_t byte;
+#include "rules.h"
+
+static const char *categoryNames[] = {
+    nullptr, "LINE_STRAIGHT", "LINE_CORNER", "LINE_T_JUNCTION", "LED_STRAIGHT", "LED_CORNER_R", "LED_CORNER_L",
+    "SW_STRAIGHT", "SW_CORNER", "PUSH_SW_STRAIGHT", "PUSH_SW_CORNER", "RESISTOR_STRAIGHT", "RESISTOR_CORNER", "PHOTODIODE"};
+static const char *groupNames[GROUP_COUNT] = {"LINE", "T_JUNCTION", "LED", "SW", "PUSH_SW", "RESISTOR", "PHOTODIODE"};
+static const char *opNames[OP_COUNT] = {"==", "!=", "<", "<=", ">", ">="};
+
+struct Source
+{
+  const char *name;
+  int line = 0;
+  int errors = 0;
+};
+
+static void error(Source &src, const char *message, const std::string &word = "")
+{
+  fprintf(stderr, "%s:%d: %s%s%s\n", src.name, src.line, message, word.empty() ? "" : ": ", word.c_str());
+  src.errors++;
+}
+
+static int findName(const char *const *names, int count, const std::string &word)
+{
+  for (int i = 0; i < count; i++)
+  {
+    if (names[i] != nullptr && word == names[i])
+      return i;
+  }
+  return -1;
+}
+
+static bool number(const std::string &word, int max, int &value)
+{
+  char *end;
+  long n = strtol(word.c_str(), &end, 10);
+  if (word.empty() || *end != '\0' || n < 0 || n > max)
+    return false;
+  value = n;
+  return true;
+}
+
+// Parse the description into the header and levels of a pack
+static bool parse(Source &src, FILE *in, LevelPack &pack, PackLevel *levels)
+{
+  memset(&pack, 0, sizeof(pack));
+  memset(levels, 0, numLevels * sizeof(PackLevel));
+  pack.magic = packMagic;
+  pack.version = packVersion;
+  pack.levels = numLevels;
+  pack.size = sizeof(LevelPack) + numLevels * sizeof(PackLevel);
+
+  bool seen[numLevels] = {};
+  int level = -1;
+  char text[512];
+
+  while (fgets(text, sizeof(text), in))
+  {
+    src.line++;
+    char *comment = strchr(text, '#');
+    if (comment)
+      *comment = '\0';
+
+    std::vector<std::string> words;
+    for (char *w = strtok(text, " \t\r\n"); w; w = strtok(nullptr, " \t\r\n"))
+    {
+      words.push_back(w);
+    }
+    if (words.empty())
+      continue;
+
+    const std::string &key = words[0];
+    int value;
+    PackLevel *lv = level >= 0 ? &levels[level] : nullptr;
+
+    if (key == "revision" && words.size() == 2)
+    {
+      pack.revision = strtoul(words[1].c_str(), nullptr, 10);
+    }
+    else if (key == "tracks")
+    {
+      for (size_t i = 1; i + 1 < words.size(); i += 2)
+      {
+        byte *track = words[i] == "mask" ? &pack.maskTrack : words[i] == "illegal" ? &pack.illegalTrack
+                                                           : words[i] == "fallback"  ? &pack.fallbackTrack
+                                                                                     : nullptr;
+        if (track == nullptr || !number(words[i + 1], 255, value))
+          error(src, "expected tracks mask t illegal t fallback t");
+        else
+          *track = value;
+      }
+    }
+    else if (key == "mask" && words.size() == 2 && words[1].size() == numGatePins &&
+             words[1].find_first_not_of("01") == std::string::npos)
+    {
+      int mask = 0;
+      for (int i = 0; i < numGatePins; i++)
+      {
+        if (words[1][i] == '1')
+          mask |= 1 << i;
+      }
+      pack.masks |= 1ULL << mask;
+    }
+    else if (key == "level" && words.size() == 2)
+    {
+      if (!number(words[1], numLevels - 1, level) || seen[level])
+      {
+        error(src, "unknown or repeated level", words[1]);
+        level = -1;
+      }
+      else
+      {
+        seen[level] = true;
+      }
+    }
+    else if (lv == nullptr)
+    {
+      error(src, "expected revision, tracks, mask or level", key);
+    }
+    else if (key == "allowed")
+    {
+      for (size_t i = 1; i < words.size(); i++)
+      {
+        int category = findName(categoryNames, 14, words[i]);
+        if (category < 0)
+          error(src, "unknown category", words[i]);
+        else
+          lv->allowed |= 1 << category;
+      }
+    }
+    else if ((key == "next" || key == "followup" || key == "restart") && words.size() == 2 && number(words[1], 255, value))
+    {
+      byte &field = key == "next" ? lv->nextLevel : key == "followup" ? lv->followUpTrack
+                                                                      : lv->restartTrack;
+      field = value;
+    }
+    else if (key == "errors" && words.size() == 1 + packAdminErrors)
+    {
+      for (int i = 0; i < packAdminErrors; i++)
+      {
+        if (!number(words[1 + i], 255, value))
+          error(src, "bad track", words[1 + i]);
+        else
+          lv->errorTracks[i] = value;
+      }
+    }
+    else if (key == "rule" && words.size() >= 3 && (words.size() - 3) % 3 == 0)
+    {
+      if (lv->rules >= packMaxRules)
+      {
+        error(src, "too many rules in the level");
+        continue;
+      }
+      PackRule &rule = lv->rule[lv->rules++];
+      if (!number(words[1], 255, value))
+        error(src, "bad track", words[1]);
+      rule.track = value;
+      if (words[2] != "all" && words[2] != "any")
+        error(src, "expected all or any", words[2]);
+      rule.any = words[2] == "any";
+
+      for (size_t i = 3; i < words.size(); i += 3)
+      {
+        if (rule.terms >= packMaxTerms)
+        {
+          error(src, "too many tests in the rule");
+          break;
+        }
+        PackTerm &term = rule.term[rule.terms++];
+        int group = findName(groupNames, GROUP_COUNT, words[i]);
+        int op = findName(opNames, OP_COUNT, words[i + 1]);
+        if (group < 0)
+          error(src, "unknown group", words[i]);
+        if (op < 0)
+          error(src, "unknown test", words[i + 1]);
+        if (!number(words[i + 2], numGatePins, value))
+          error(src, "bad count", words[i + 2]);
+        term.group = group < 0 ? 0 : group;
+        term.op = op < 0 ? 0 : op;
+        term.value = value;
+      }
+    }
+    else
+    {
+      error(src, "cannot read line", key);
+    }
+  }
+
+  for (int l = 0; l < numLevels; l++)
+  {
+    if (!seen[l])
+    {
+      fprintf(stderr, "%s: level %d is missing\n", src.name, l);
+      src.errors++;
+    }
+    else if (levels[l].rules == 0)
+    {
+      fprintf(stderr, "%s: level %d has no rules\n", src.name, l);
+      src.errors++;
+    }
+  }
+  if (pack.masks == 0)
+  {
+    fprintf(stderr, "%s: no connection masks\n", src.name);
+    src.errors++;
+  }
+  return src.errors == 0;
+}
+
+struct Report
+{
+  long decided[numLevels][BRANCH_COUNT] = {};
+  long differences = 0;
+  int maskDifferences = 0;
+};
+
+// Evaluate every group histogram at every level with the pack and with the
+// built-in levels
+static void compareHistograms(const LevelPack *pack, int group, int gate, Report &report)
+{
+  if (group == GROUP_COUNT)
+  {
+    for (int i = gate; i < numGatePins; i++)
+    {
+      presentCards[i] = 0;
+    }
+    countCards();
+
+    for (int level = 0; level < numLevels; level++)
+    {
+      levelPack = pack;
+      Outcome packed = outcomeFromBranch(level, evaluateRules(level));
+      levelPack = nullptr;
+      Outcome builtIn = outcomeFromBranch(level, evaluateRules(level));
+
+      report.decided[level][packed.branch]++;
+      if (packed.branch != builtIn.branch || packed.track != builtIn.track || packed.nextLevel != builtIn.nextLevel)
+        report.differences++;
+    }
+    return;
+  }
+
+  for (int count = 0; gate + count <= numGatePins; count++)
+  {
+    for (int i = 0; i < count; i++)
+    {
+      presentCards[gate + i] = groupCategory[group];
+    }
+    compareHistograms(pack, group + 1, gate + count, report);
+  }
+}
+
+static void compareMasks(const LevelPack *pack, Report &report)
+{
+  for (int mask = 0; mask < 64; mask++)
+  {
+    for (int i = 0; i < numGatePins; i++)
+    {
+      presentCards[i] = (mask >> i) & 1 ? LINE_STRAIGHT : 0;
+    }
+    levelPack = pack;
+    bool packed = matchConnectionMasks();
+    levelPack = nullptr;
+    if (packed != matchConnectionMasks())
+      report.maskDifferences++;
+  }
+}
+
+// Send the pack with PACK and print the console lines of the reply
+static bool upload(const char *device, const std::vector<byte> &image)
+{
+  int fd = open(device, O_RDWR | O_NOCTTY);
+  if (fd < 0)
+  {
+    perror(device);
+    return false;
+  }
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0)
+  {
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, B9600);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 1;
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+
+  char command[32];
+  int length = snprintf(command, sizeof(command), "PACK %zu\n", image.size());
+  if (write(fd, command, length) != length || write(fd, image.data(), image.size()) != (ssize_t)image.size())
+  {
+    perror(device);
+    close(fd);
+    return false;
+  }
+
+  // The reply shares the port with telemetry frames, keep the text lines
+  std::string line;
+  time_t start = time(nullptr);
+  while (time(nullptr) - start < 3)
+  {
+    char c;
+    if (read(fd, &c, 1) != 1)
+      continue;
+    if (c == '\n')
+    {
+      if (line.compare(0, 4, "Pack") == 0 || line.compare(0, 6, "Levels") == 0 || line.compare(0, 5, "Usage") == 0)
+        printf("%s: %s\n", device, line.c_str());
+      line.clear();
+    }
+    else if (c >= ' ' && c < 127)
+    {
+      line += c;
+    }
+  }
+  close(fd);
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  const char *input = nullptr;
+  const char *output = nullptr;
+  const char *device = nullptr;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+      output = argv[++i];
+    else if (strcmp(argv[i], "--upload") == 0 && i + 1 < argc)
+      device = argv[++i];
+    else if (input == nullptr)
+      input = argv[i];
+    else
+      input = nullptr, i = argc;
+  }
+  if (input == nullptr)
+  {
+    fprintf(stderr, "usage: %s levels.txt [-o pack.bin] [--upload /dev/ttyACM0]\n", argv[0]);
+    return 2;
+  }
+
+  FILE *in = fopen(input, "r");
+  if (!in)
+  {
+    perror(input);
+    return 1;
+  }
+
+  Source src = {input};
+  LevelPack header;
+  PackLevel levels[numLevels];
+  bool parsed = parse(src, in, header, levels);
+  fclose(in);
+  if (!parsed)
+    return 1;
+
+  std::vector<byte> image(header.size);
+  memcpy(image.data(), &header, sizeof(header));
+  memcpy(image.data() + sizeof(header), levels, sizeof(levels));
+  uint16_t crc = packCrc(image.data(), image.size());
+  memcpy(image.data() + packCrcOffset, &crc, sizeof(crc));
+
+  const char *problem = levelPackProblem(image.data(), image.size());
+  if (problem != nullptr)
+  {
+    fprintf(stderr, "%s: %s\n", input, problem);
+    return 1;
+  }
+
+  const LevelPack *pack = (const LevelPack *)image.data();
+  printf("Pack: revision %u, %d levels, %zu bytes, CRC 0x%04X\n", (unsigned)pack->revision, pack->levels,
+         image.size(), crc);
+
+  Report report;
+  compareHistograms(pack, 0, 0, report);
+  compareMasks(pack, report);
+
+  for (int level = 0; level < numLevels; level++)
+  {
+    const PackLevel &lv = packLevels(pack)[level];
+    printf("level %d:", level);
+    for (int r = 0; r < lv.rules; r++)
+    {
+      printf(" rule %d %ld", r, report.decided[level][BRANCH_RULE_0 + r]);
+    }
+    printf(", illegal %ld, fallback %ld (of %d histograms)\n", report.decided[level][BRANCH_ILLEGAL],
+           report.decided[level][BRANCH_FALLBACK], numHistograms);
+    for (int r = 0; r < lv.rules; r++)
+    {
+      if (report.decided[level][BRANCH_RULE_0 + r] == 0)
+        printf("  warning: rule %d never decides an outcome\n", r);
+    }
+  }
+  printf("Compared with the built-in levels: %ld of %d outcomes and %d of 64 masks differ\n", report.differences,
+         numLevels * numHistograms, report.maskDifferences);
+
+  if (output)
+  {
+    FILE *out = fopen(output, "wb");
+    if (!out || fwrite(image.data(), 1, image.size(), out) != image.size() || fclose(out) != 0)
+    {
+      perror(output);
+      return 1;
+    }
+    printf("Wrote %s\n", output);
+  }
+
+  if (device && !upload(device, image))
+    return 1;
+  return 0;
+}
@@ -0,0 +1,111 @@
+# Flash and RAM of the firmware by subsystem, from the symbol sizes and the
+# source lines in the ELF. A subsystem is a file in src/ (reader.h, rules.h,
+# UID.h, ...), a library from lib_deps or the Arduino core; symbols without
+# line information count as "other". Initialised data counts twice: its
+# image in flash and its copy in RAM.
+#
+# As a PlatformIO post-build script (extra_scripts in platformio.ini) it runs
+# after every link and warns when the image or the static RAM passes
+# custom_mem_alarm percent of the board. On its own:
+#   python3 tools/mem_report/mem_report.py .pio/build/pico/firmware.elf [--nm arm-none-eabi-nm]
+
+import os
+import re
+import subprocess
+import sys
+
+FLASH_TYPES = "TtWwVvRr"
+DATA_TYPES = "DdGg"
+BSS_TYPES = "BbSs"
+
+
+def subsystem(path, src_dir):
+    path = os.path.normpath(path)
+    if path.startswith(src_dir + os.sep):
+        return os.path.relpath(path, src_dir)
+    match = re.search(r"libdeps[\\/][^\\/]+[\\/]([^\\/]+)", path)
+    if match:
+        return "lib " + match.group(1)
+    if "framework-arduinopico" in path or "pico-sdk" in path:
+        return "core"
+    return "other"
+
+
+def breakdown(nm, elf, src_dir):
+    output = subprocess.run([nm, "--print-size", "--line-numbers", elf],
+                            capture_output=True, text=True, check=True).stdout
+    sizes = {}
+    for line in output.splitlines():
+        fields, _, location = line.partition("\t")
+        parts = fields.split()
+        if len(parts) < 4:
+            continue
+        size, kind = int(parts[1], 16), parts[2]
+        name = subsystem(location.rsplit(":", 1)[0], src_dir) if location else "other"
+        flash, ram = sizes.get(name, (0, 0))
+        if kind in FLASH_TYPES:
+            flash += size
+        elif kind in DATA_TYPES:
+            flash += size
+            ram += size
+        elif kind in BSS_TYPES:
+            ram += size
+        sizes[name] = (flash, ram)
+    return sizes
+
+
+def print_report(sizes, flash_budget, ram_budget, alarm):
+    flash_total = sum(f for f, _ in sizes.values())
+    ram_total = sum(r for _, r in sizes.values())
+    print("Memory by subsystem (bytes)")
+    print("  %-24s %9s %9s" % ("subsystem", "flash", "RAM"))
+    for name, (flash, ram) in sorted(sizes.items(), key=lambda item: -(item[1][0] + item[1][1])):
+        print("  %-24s %9d %9d" % (name, flash, ram))
+    print("  %-24s %9d %9d" % ("total", flash_total, ram_total))
+
+    warnings = 0
+    for label, used, budget in (("flash", flash_total, flash_budget), ("static RAM", ram_total, ram_budget)):
+        if not budget:
+            continue
+        percent = 100.0 * used / budget
+        print("  %s: %d of %d bytes, %.1f%%" % (label, used, budget, percent))
+        if percent >= alarm:
+            print("Warning: %s use is above %d%%" % (label, alarm))
+            warnings += 1
+    return warnings
+
+
+def parse_size(text):
+    match = re.fullmatch(r"\s*(\d+)\s*([kKmM]?)[bB]?\s*", str(text))
+    if not match:
+        return 0
+    return int(match.group(1)) * {"": 1, "k": 1024, "m": 1024 * 1024}[match.group(2).lower()]
+
+
+def post_build(source, target, env):
+    nm = os.path.join(os.path.dirname(env.subst("$CC")), env.subst("$CC").split(os.sep)[-1].replace("gcc", "nm"))
+    board = env.BoardConfig()
+    flash_budget = int(board.get("upload.maximum_size", 0)) - parse_size(
+        env.GetProjectOption("board_build.filesystem_size", "0"))
+    ram_budget = int(board.get("upload.maximum_ram_size", 0))
+    alarm = int(env.GetProjectOption("custom_mem_alarm", "80"))
+    sizes = breakdown(nm, str(target[0]), os.path.normpath(env.subst("$PROJECT_SRC_DIR")))
+    print_report(sizes, flash_budget, ram_budget, alarm)
+
+
+try:
+    Import("env")
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", post_build)
+except NameError:
+    if __name__ == "__main__":
+        args = sys.argv[1:]
+        nm = "arm-none-eabi-nm"
+        if "--nm" in args:
+            i = args.index("--nm")
+            nm = args[i + 1]
+            del args[i:i + 2]
+        if len(args) != 1:
+            sys.exit("usage: mem_report.py firmware.elf [--nm arm-none-eabi-nm]")
+        src = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "src"))
+        # Pico: 2 MB flash less the 64 KB filesystem, 264 KB RAM
+        sys.exit(1 if print_report(breakdown(nm, args[0], src), 2048 * 1024 - 64 * 1024, 264 * 1024, 80) else 0)
@@ -0,0 +1,121 @@
+// Arduino API for tools/reader_emu: just enough for src/reader.h and the
+// MFRC522 library. Time, pins and the SPI bus are provided by the emulator.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define DEC 10
+#define HEX 16
+#define BIN 2
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<const __FlashStringHelper *>(text))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+template <class T>
+T max(T a, T b)
+{
+  return a > b ? a : b;
+}
+
+template <class T>
+T min(T a, T b)
+{
+  return a < b ? a : b;
+}
+
+// Console output of the firmware, shown with --debug
+class HostSerial
+{
+public:
+  bool enabled = false;
+
+  void begin(unsigned long) {}
+  operator bool() { return true; }
+  int available() { return 0; }
+  int read() { return -1; }
+  int availableForWrite() { return 4096; }
+  void flush() { fflush(stdout); }
+
+  size_t write(uint8_t c) { return enabled ? fputc(c, stdout) != EOF : 1; }
+  size_t write(const uint8_t *data, size_t size)
+  {
+    for (size_t i = 0; i < size; i++)
+      write(data[i]);
+    return size;
+  }
+
+  size_t print(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+  size_t print(const __FlashStringHelper *text) { return print((const char *)text); }
+  size_t print(char c) { return write(c); }
+  size_t print(unsigned long long value, int base = DEC)
+  {
+    char digits[65];
+    int n = 0;
+    do
+    {
+      int d = value % base;
+      digits[n++] = d < 10 ? '0' + d : 'A' + d - 10;
+      value /= base;
+    } while (value > 0);
+    size_t written = 0;
+    while (n > 0)
+      written += write(digits[--n]);
+    return written;
+  }
+  size_t print(long long value, int base = DEC)
+  {
+    if (value < 0 && base == DEC)
+      return print('-') + print((unsigned long long)-value, base);
+    return print((unsigned long long)value, base);
+  }
+  size_t print(unsigned char value, int base = DEC) { return print((unsigned long long)value, base); }
+  size_t print(int value, int base = DEC) { return print((long long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long long)value, base); }
+  size_t print(long value, int base = DEC) { return print((long long)value, base); }
+  size_t print(unsigned long value, int base = DEC) { return print((unsigned long long)value, base); }
+  size_t print(double value, int places = 2)
+  {
+    char text[32];
+    snprintf(text, sizeof(text), "%.*f", places, value);
+    return print(text);
+  }
+
+  size_t println() { return write('\r') + write('\n'); }
+  template <class T>
+  size_t println(T value) { return print(value) + println(); }
+  template <class T>
+  size_t println(T value, int format) { return print(value, format) + println(); }
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,27 @@
+// SPI bus of tools/reader_emu, transfers go to the emulated reader
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+class SPISettings
+{
+public:
+  SPISettings(uint32_t clock = 4000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0) : clock(clock) {}
+  uint32_t clock;
+};
+
+class SPIClass
+{
+public:
+  void begin() {}
+  void end() {}
+  void beginTransaction(SPISettings settings);
+  void endTransaction() {}
+  uint8_t transfer(uint8_t data);
+  void transfer(void *buffer, size_t count);
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,13 @@
+// Gate lines of tools/reader_emu, the emulator powers the reader of the open gate
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include <stdint.h>
+
+void gpio_init_mask(uint32_t mask);
+void gpio_set_dir_out_masked(uint32_t mask);
+void gpio_clr_mask(uint32_t mask);
+void gpio_set_mask(uint32_t mask);
+void gpio_put_masked(uint32_t mask, uint32_t value);
+
+#endif
@@ -0,0 +1,18 @@
+// Watchdog of tools/reader_emu: the scratch registers are plain memory
+#ifndef HOST_HARDWARE_WATCHDOG_H
+#define HOST_HARDWARE_WATCHDOG_H
+
+#include <stdint.h>
+
+typedef struct
+{
+  uint32_t scratch[8];
+} watchdog_hw_t;
+
+extern watchdog_hw_t *watchdog_hw;
+
+inline void watchdog_enable(uint32_t, bool) {}
+inline void watchdog_update() {}
+inline bool watchdog_enable_caused_reboot() { return false; }
+
+#endif
@@ -0,0 +1,1027 @@
+// Register-level MFRC522 emulator for benchmarking the gate reader on a
+// Linux machine.
+//
+// src/reader.h is compiled unchanged against host versions of Arduino.h,
+// SPI.h and the pico gpio and watchdog headers (tools/reader_emu/host) and the
+// real MFRC522 library. Every SPI byte goes to an emulated reader that models
+// the register file, the FIFO, the timer, ComIrqReg and DivIrqReg, CalcCRC and
+// Transceive with ISO 14443A frame timing, and virtual NTAG21x tags with 4, 7
+// or 10 byte UIDs placed on the gates. Time is virtual: SPI bytes take 8 clock
+// periods, frames on the air take their bit time, delays take what they ask.
+//
+// Each gate powers a reader of its own, which answers settle us after the gate
+// opens and loses its registers when the gate closes. --shared-reader models
+// one reader that stays powered while the gates switch its antenna instead.
+//
+// The tool runs the boot steps that touch the reader (initializeReader(),
+// calibrateGates()) and then reads every gate like readGate() in main.cpp,
+// with the lean path and with the library path. Per gate read it reports the
+// SPI transactions and bytes, the bus time at the SPI clock and the time the
+// read took, and checks the category against the tags; the exit status is 1
+// when a read returns the wrong category.
+//
+// Build and run on the host from the repository root, the MFRC522 library is
+// the one PlatformIO fetched for the firmware build:
+//   lib=.pio/libdeps/pico/MFRC522/src
+//   g++ -O2 -std=c++17 -fconstexpr-ops-limit=268435456 -I tools/reader_emu/host -I src -I $lib
+//       tools/reader_emu/reader_emu.cpp $lib/MFRC522.cpp -o reader_emu
+//   ./reader_emu [--spi-clock hz] [--passes n] [--mode fast|library|both] [--shared-reader]
+//                [--settle us] [--drop p] [--seed n] [--trace] [--debug]
+//                [--tag gate:uid[:category]] ...
+//
+// A tag is given by its gate (1-6), its UID in hex (8, 14 or 20 digits) and
+// optionally the category written to its category page; tags without one are
+// looked up in the registry. Without --tag a default board with every UID
+// size is used. --drop makes tags ignore that fraction of the frames sent to
+// them, to exercise the retries and the library fallback.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include <SPI.h>
+
+bool DEBUG = false; // Firmware console output, --debug
+
+#include "reader.h"
+
+// Reader registers (addresses, not the shifted library values)
+enum Register
+{
+  R_COMMAND = 0x01,
+  R_COM_IEN = 0x02,
+  R_DIV_IEN = 0x03,
+  R_COM_IRQ = 0x04,
+  R_DIV_IRQ = 0x05,
+  R_ERROR = 0x06,
+  R_STATUS1 = 0x07,
+  R_STATUS2 = 0x08,
+  R_FIFO_DATA = 0x09,
+  R_FIFO_LEVEL = 0x0A,
+  R_WATER_LEVEL = 0x0B,
+  R_CONTROL = 0x0C,
+  R_BIT_FRAMING = 0x0D,
+  R_COLL = 0x0E,
+  R_MODE = 0x11,
+  R_TX_MODE = 0x12,
+  R_RX_MODE = 0x13,
+  R_TX_CONTROL = 0x14,
+  R_TX_ASK = 0x15,
+  R_CRC_RESULT_H = 0x21,
+  R_CRC_RESULT_L = 0x22,
+  R_MOD_WIDTH = 0x24,
+  R_RF_CFG = 0x26,
+  R_T_MODE = 0x2A,
+  R_T_PRESCALER = 0x2B,
+  R_T_RELOAD_H = 0x2C,
+  R_T_RELOAD_L = 0x2D,
+  R_T_COUNTER_H = 0x2E,
+  R_T_COUNTER_L = 0x2F,
+  R_VERSION = 0x37
+};
+
+enum ChipCommand
+{
+  C_IDLE = 0x00,
+  C_MEM = 0x01,
+  C_CALC_CRC = 0x03,
+  C_TRANSMIT = 0x04,
+  C_RECEIVE = 0x08,
+  C_TRANSCEIVE = 0x0C,
+  C_SOFT_RESET = 0x0F
+};
+
+// ComIrqReg and DivIrqReg bits
+const byte IRQ_TX = 0x40, IRQ_RX = 0x20, IRQ_IDLE = 0x10, IRQ_TIMER = 0x01, IRQ_CRC = 0x04;
+// ErrorReg bits
+const byte ERR_PROTOCOL = 0x01, ERR_COLL = 0x08, ERR_BUFFER_OVFL = 0x10;
+
+const double carrierHz = 13.56e6;
+const double bitUs = 128 / carrierHz * 1e6; // 106 kbit/s
+const double frameDelayUs = 1236 / carrierHz * 1e6; // Frame delay time of a tag answer
+const double oscillatorUs = 40;       // Crystal start after reset or power up
+const double tagPowerUpUs = 1000;     // Field time before a tag answers
+const int tagPages = 45;              // NTAG213
+
+const char *registerNames[64] = {
+    "Reserved00", "CommandReg", "ComIEnReg", "DivIEnReg", "ComIrqReg", "DivIrqReg", "ErrorReg", "Status1Reg",
+    "Status2Reg", "FIFODataReg", "FIFOLevelReg", "WaterLevelReg", "ControlReg", "BitFramingReg", "CollReg", "Reserved0F",
+    "Reserved10", "ModeReg", "TxModeReg", "RxModeReg", "TxControlReg", "TxASKReg", "TxSelReg", "RxSelReg",
+    "RxThresholdReg", "DemodReg", "Reserved1A", "Reserved1B", "MfTxReg", "MfRxReg", "Reserved1E", "SerialSpeedReg",
+    "Reserved20", "CRCResultRegH", "CRCResultRegL", "Reserved23", "ModWidthReg", "Reserved25", "RFCfgReg", "GsNReg",
+    "CWGsPReg", "ModGsPReg", "TModeReg", "TPrescalerReg", "TReloadRegH", "TReloadRegL", "TCounterValueRegH", "TCounterValueRegL",
+    "Reserved30", "TestSel1Reg", "TestSel2Reg", "TestPinEnReg", "TestPinValueReg", "TestBusReg", "AutoTestReg", "VersionReg",
+    "AnalogTestReg", "TestDAC1Reg", "TestDAC2Reg", "TestADCReg", "Reserved3C", "Reserved3D", "Reserved3E", "Reserved3F"};
+
+struct Options
+{
+  double spiClock = 0;  // 0: the clock of each SPI transaction
+  int passes = 3;
+  bool fast = true;
+  bool library = true;
+  bool sharedReader = false;
+  double settleUs = 2000;
+  double dropRate = 0;
+  bool trace = false;
+} options;
+
+// Virtual time in microseconds
+double nowUs = 0;
+const double callUs = 0.05; // Cost of a micros() or millis() call, keeps wait loops finite
+
+double uniform()
+{
+  return rand() / (RAND_MAX + 1.0);
+}
+
+uint16_t crc16A(const byte *data, int length)
+{
+  return crcA(data, length); // src/reader.h
+}
+
+// A frame on the air: whole bytes, the last one may be cut short
+struct Frame
+{
+  std::vector<byte> bytes;
+  int lastBits = 0; // Valid bits of the last byte, 0 for 8
+
+  int bits() const
+  {
+    return bytes.empty() ? 0 : (int)(bytes.size() - 1) * 8 + (lastBits ? lastBits : 8);
+  }
+
+  // With a parity bit per whole byte, start and end of frame
+  double airUs() const
+  {
+    return (bits() + bits() / 8 + 2) * bitUs;
+  }
+};
+
+Frame withCrc(std::vector<byte> bytes)
+{
+  uint16_t crc = crc16A(bytes.data(), bytes.size());
+  bytes.push_back(crc & 0xFF);
+  bytes.push_back(crc >> 8);
+  return {bytes, 0};
+}
+
+// NTAG21x answering ISO 14443A
+struct Tag
+{
+  enum State
+  {
+    IDLE,
+    READY,
+    ACTIVE,
+    HALT
+  };
+
+  int gate = 0;
+  byte uid[10] = {};
+  int uidSize = 4;
+  byte category = 0; // Category page content, 0 for none
+  byte pages[tagPages * 4] = {};
+  State state = IDLE;
+  int cascade = 0; // Cascade level being selected
+
+  int levels() const
+  {
+    return uidSize == 4 ? 1 : uidSize == 7 ? 2 : 3;
+  }
+
+  // UID bytes sent at a cascade level, with the cascade tag when more follow
+  void levelBytes(int level, byte out[4]) const
+  {
+    int offset = level * 3;
+    if (level < levels() - 1)
+    {
+      out[0] = 0x88;
+      memcpy(out + 1, uid + offset, 3);
+    }
+    else
+    {
+      memcpy(out, uid + offset, 4);
+    }
+  }
+
+  void setup()
+  {
+    memset(pages, 0, sizeof(pages));
+    memcpy(pages, uid, uidSize < 8 ? uidSize : 8);
+    pages[12] = 0xE1; // Capability container
+    pages[13] = 0x10;
+    pages[14] = 0x12;
+    if (category != 0)
+    {
+      MFRC522::Uid id;
+      id.size = uidSize;
+      memcpy(id.uidByte, uid, uidSize);
+      byte *page = pages + categoryPage * 4;
+      page[0] = categoryMagic0;
+      page[1] = categoryMagic1;
+      page[2] = category;
+      page[3] = categoryChecksum(id, category);
+    }
+  }
+
+  // Answer to a frame, empty when the tag stays silent
+  Frame receive(const Frame &in)
+  {
+    Frame out;
+    if (options.dropRate > 0 && uniform() < options.dropRate)
+      return out;
+
+    const std::vector<byte> &b = in.bytes;
+    if (in.lastBits == 7 && b.size() == 1)
+    {
+      bool wupa = b[0] == 0x52;
+      if ((b[0] == 0x26 && state == IDLE) || (wupa && (state == IDLE || state == HALT)))
+      {
+        state = READY;
+        cascade = 0;
+        byte sizeBits = uidSize == 4 ? 0x00 : uidSize == 7 ? 0x40 : 0x80;
+        out.bytes = {(byte)(sizeBits | 0x04), 0x00};
+      }
+      else
+      {
+        state = IDLE;
+      }
+      return out;
+    }
+    if (in.lastBits != 0 || b.empty())
+    {
+      state = IDLE;
+      return out;
+    }
+
+    bool crcOk = b.size() >= 3 && crc16A(b.data(), b.size()) == 0;
+
+    if (state == READY && b.size() >= 2 && b[0] == 0x93 + 2 * cascade)
+    {
+      byte level[4];
+      levelBytes(cascade, level);
+      if (b[1] == 0x20 && b.size() == 2)
+      {
+        // Anticollision without known bits, a tag alone answers whole
+        out.bytes.assign(level, level + 4);
+        out.bytes.push_back(level[0] ^ level[1] ^ level[2] ^ level[3]);
+        return out;
+      }
+      if (b[1] == 0x70 && b.size() == 9 && crcOk && memcmp(b.data() + 2, level, 4) == 0)
+      {
+        bool more = ++cascade < levels();
+        if (!more)
+          state = ACTIVE;
+        return withCrc({(byte)(more ? 0x04 : 0x00)});
+      }
+      // Anticollision with known bits is only needed with several tags per gate
+      state = IDLE;
+      return out;
+    }
+
+    if (state == ACTIVE && crcOk)
+    {
+      if (b[0] == 0x30 && b.size() == 4)
+      {
+        if (b[1] >= tagPages)
+        {
+          state = IDLE;
+          return {{0x00}, 4}; // NAK
+        }
+        std::vector<byte> data;
+        for (int i = 0; i < 16; i++)
+          data.push_back(pages[(b[1] * 4 + i) % (tagPages * 4)]);
+        return withCrc(data);
+      }
+      if (b[0] == 0xA2 && b.size() == 8)
+      {
+        if (b[1] < 4 || b[1] >= tagPages - 5)
+        {
+          state = IDLE;
+          return {{0x00}, 4};
+        }
+        memcpy(pages + b[1] * 4, b.data() + 2, 4);
+        return {{0x0A}, 4}; // ACK
+      }
+      if (b[0] == 0x50 && b.size() == 4)
+      {
+        state = HALT;
+        return out;
+      }
+    }
+
+    state = state == HALT ? HALT : IDLE;
+    return out;
+  }
+};
+
+std::vector<Tag> tags;
+
+// One MFRC522
+struct Chip
+{
+  byte regs[64];
+  byte fifo[64];
+  int fifoLevel = 0;
+  bool powered = false;
+  double readyAt = 0;   // Registers answer from here on
+  double fieldSince = -1;
+
+  // Transceive in progress
+  bool txPending = false;
+  double txEnd = 0;
+  bool rxPending = false;
+  double rxStart = 0;
+  double rxEnd = 0;
+  Frame reply;
+  bool timerRunning = false;
+  double timerEnd = 0;
+
+  void reset()
+  {
+    memset(regs, 0, sizeof(regs));
+    regs[R_COMMAND] = 0x20;
+    regs[R_COM_IEN] = 0x80;
+    regs[R_COM_IRQ] = 0x14;
+    regs[R_STATUS1] = 0x21;
+    regs[R_WATER_LEVEL] = 0x08;
+    regs[R_CONTROL] = 0x10;
+    regs[R_COLL] = 0xA0;
+    regs[R_MODE] = 0x3F;
+    regs[R_TX_CONTROL] = 0x80;
+    regs[0x16] = 0x10;
+    regs[0x17] = 0x84;
+    regs[0x18] = 0x84;
+    regs[0x19] = 0x4D;
+    regs[0x1C] = 0x62;
+    regs[0x1F] = 0xEB;
+    regs[R_CRC_RESULT_H] = 0xFF;
+    regs[R_CRC_RESULT_L] = 0xFF;
+    regs[R_MOD_WIDTH] = 0x26;
+    regs[R_RF_CFG] = 0x48;
+    regs[0x27] = 0x88;
+    regs[0x28] = 0x20;
+    regs[0x29] = 0x20;
+    regs[R_VERSION] = 0x92;
+    fifoLevel = 0;
+    txPending = rxPending = timerRunning = false;
+    fieldSince = -1;
+  }
+
+  bool answers() const
+  {
+    return powered && nowUs >= readyAt;
+  }
+
+  bool fieldOn() const
+  {
+    return (regs[R_TX_CONTROL] & 0x03) != 0;
+  }
+
+  double timerUs() const
+  {
+    int prescaler = (regs[R_T_MODE] & 0x0F) << 8 | regs[R_T_PRESCALER];
+    int reload = regs[R_T_RELOAD_H] << 8 | regs[R_T_RELOAD_L];
+    return (reload + 1.0) * (2.0 * prescaler + 1) / carrierHz * 1e6;
+  }
+
+  void startTimer(double at)
+  {
+    timerRunning = true;
+    timerEnd = at + timerUs();
+  }
+
+  void pushFifo(byte value)
+  {
+    if (fifoLevel >= 64)
+    {
+      regs[R_ERROR] |= ERR_BUFFER_OVFL;
+      return;
+    }
+    fifo[fifoLevel++] = value;
+  }
+
+  byte popFifo()
+  {
+    if (fifoLevel == 0)
+      return 0;
+    byte value = fifo[0];
+    memmove(fifo, fifo + 1, --fifoLevel);
+    return value;
+  }
+
+  // Apply what happened on the air up to now
+  void update()
+  {
+    if (txPending && nowUs >= txEnd)
+    {
+      txPending = false;
+      regs[R_COM_IRQ] |= IRQ_TX;
+      if (regs[R_T_MODE] & 0x80)
+        startTimer(txEnd);
+      if (rxPending && timerRunning && rxStart < timerEnd)
+        timerRunning = false; // The timer stops when the answer starts
+    }
+    if (rxPending && !txPending && nowUs >= rxEnd)
+    {
+      rxPending = false;
+      for (byte value : reply.bytes)
+        pushFifo(value);
+      regs[R_CONTROL] = (regs[R_CONTROL] & ~0x07) | reply.lastBits;
+      regs[R_COM_IRQ] |= IRQ_RX;
+    }
+    if (timerRunning && nowUs >= timerEnd)
+    {
+      timerRunning = false;
+      regs[R_COM_IRQ] |= IRQ_TIMER;
+    }
+  }
+
+  Tag *tagInField();
+
+  void transceive()
+  {
+    Frame frame;
+    frame.bytes.assign(fifo, fifo + fifoLevel);
+    frame.lastBits = regs[R_BIT_FRAMING] & 0x07;
+    fifoLevel = 0;
+    if (regs[R_TX_MODE] & 0x80)
+    {
+      uint16_t crc = crc16A(frame.bytes.data(), frame.bytes.size());
+      frame.bytes.push_back(crc & 0xFF);
+      frame.bytes.push_back(crc >> 8);
+    }
+
+    regs[R_ERROR] &= ~(ERR_PROTOCOL | ERR_COLL);
+    txPending = true;
+    txEnd = nowUs + frame.airUs();
+    rxPending = false;
+    timerRunning = false;
+
+    Tag *tag = tagInField();
+    if (tag && fieldOn() && nowUs - fieldSince >= tagPowerUpUs)
+    {
+      reply = tag->receive(frame);
+      if (!reply.bytes.empty())
+      {
+        rxPending = true;
+        rxStart = txEnd + frameDelayUs;
+        rxEnd = rxStart + reply.airUs();
+      }
+    }
+  }
+
+  void calcCrc()
+  {
+    static const uint16_t presets[4] = {0x0000, 0x6363, 0xA671, 0xFFFF};
+    uint16_t crc = presets[regs[R_MODE] & 0x03];
+    for (int i = 0; i < fifoLevel; i++)
+    {
+      byte b = fifo[i] ^ (crc & 0xFF);
+      b ^= b << 4;
+      crc = (crc >> 8) ^ ((uint16_t)b << 8) ^ ((uint16_t)b << 3) ^ (b >> 4);
+    }
+    fifoLevel = 0;
+    regs[R_CRC_RESULT_H] = crc >> 8;
+    regs[R_CRC_RESULT_L] = crc & 0xFF;
+    regs[R_DIV_IRQ] |= IRQ_CRC;
+  }
+
+  void command(byte value)
+  {
+    byte previous = regs[R_COMMAND] & 0x0F;
+    byte cmd = value & 0x0F;
+    regs[R_COMMAND] = value & 0x3F;
+
+    switch (cmd)
+    {
+    case C_SOFT_RESET:
+      reset();
+      readyAt = nowUs + oscillatorUs;
+      return;
+    case C_IDLE:
+      txPending = rxPending = false;
+      if (previous != C_IDLE)
+        regs[R_COM_IRQ] |= IRQ_IDLE;
+      break;
+    case C_CALC_CRC:
+      calcCrc();
+      break;
+    default:
+      break;
+    }
+  }
+
+  byte read(int reg)
+  {
+    update();
+    switch (reg)
+    {
+    case R_FIFO_DATA:
+      return popFifo();
+    case R_FIFO_LEVEL:
+      return fifoLevel;
+    case R_T_COUNTER_H:
+    case R_T_COUNTER_L:
+    {
+      int ticks = 0;
+      if (timerRunning)
+        ticks = (int)((timerEnd - nowUs) / timerUs() * (regs[R_T_RELOAD_H] << 8 | regs[R_T_RELOAD_L]));
+      return reg == R_T_COUNTER_H ? ticks >> 8 : ticks & 0xFF;
+    }
+    default:
+      return regs[reg];
+    }
+  }
+
+  void write(int reg, byte value)
+  {
+    update();
+    switch (reg)
+    {
+    case R_COMMAND:
+      command(value);
+      break;
+    case R_COM_IRQ:
+    case R_DIV_IRQ:
+      if (value & 0x80)
+        regs[reg] |= value & 0x7F;
+      else
+        regs[reg] &= ~value;
+      break;
+    case R_FIFO_DATA:
+      pushFifo(value);
+      if ((regs[R_COMMAND] & 0x0F) == C_CALC_CRC)
+        calcCrc();
+      break;
+    case R_FIFO_LEVEL:
+      if (value & 0x80)
+      {
+        fifoLevel = 0;
+        regs[R_ERROR] &= ~ERR_BUFFER_OVFL;
+      }
+      break;
+    case R_BIT_FRAMING:
+      regs[reg] = value & 0x7F; // StartSend reads back as 0 once sent
+      if ((value & 0x80) && (regs[R_COMMAND] & 0x0F) == C_TRANSCEIVE)
+        transceive();
+      break;
+    case R_CONTROL:
+      if (value & 0x80)
+        timerRunning = false;
+      if (value & 0x40)
+        startTimer(nowUs);
+      break;
+    case R_TX_CONTROL:
+    {
+      bool wasOn = fieldOn();
+      regs[reg] = value;
+      if (!wasOn && fieldOn())
+        fieldSince = nowUs;
+      if (!fieldOn())
+        fieldSince = -1;
+      break;
+    }
+    case R_ERROR:
+    case R_STATUS1:
+    case R_CRC_RESULT_H:
+    case R_CRC_RESULT_L:
+    case R_VERSION:
+      break; // Read only
+    default:
+      regs[reg] = value;
+      break;
+    }
+  }
+};
+
+// Bus and pins
+
+struct Counters
+{
+  unsigned long transactions = 0;
+  unsigned long bytes = 0;
+  double busUs = 0;
+};
+
+Chip gateChips[numGates];
+Chip sharedChip;
+int openGateIndex = -1;   // -1 while all gates are closed
+uint32_t gateLines = 0;
+byte pinLevel[64];
+bool resetHeld = false;   // NRSTPD low: hard power down
+uint32_t transactionClock = 4000000;
+bool csLow = false;
+int frameBytes = 0;
+bool frameRead = false;
+int frameAddress = 0;
+Counters counters;
+
+HostSerial Serial;
+SPIClass SPI;
+watchdog_hw_t watchdogRegisters;
+watchdog_hw_t *watchdog_hw = &watchdogRegisters;
+
+Chip *activeChip()
+{
+  if (options.sharedReader)
+    return &sharedChip;
+  return openGateIndex >= 0 ? &gateChips[openGateIndex] : nullptr;
+}
+
+Tag *Chip::tagInField()
+{
+  for (Tag &t : tags)
+  {
+    if (t.gate == openGateIndex)
+      return &t;
+  }
+  return nullptr;
+}
+
+// Tags lose power when the field goes, readers when their gate closes
+void switchGate(int gate)
+{
+  if (gate == openGateIndex)
+    return;
+  for (Tag &t : tags)
+    t.state = Tag::IDLE;
+
+  if (!options.sharedReader && openGateIndex >= 0)
+    gateChips[openGateIndex].powered = false;
+  openGateIndex = gate;
+
+  Chip *chip = activeChip();
+  if (!options.sharedReader && chip)
+  {
+    chip->reset();
+    chip->powered = true;
+    chip->readyAt = nowUs + options.settleUs;
+  }
+  if (chip && chip->fieldOn())
+    chip->fieldSince = nowUs;
+}
+
+void updateGateLines()
+{
+  int gate = -1;
+  for (int i = 0; i < numGates; i++)
+  {
+    if (gateLines & (1UL << gatePins[i]))
+      gate = gate == -1 ? i : -2;
+  }
+  switchGate(gate >= 0 ? gate : -1); // Two open gates short the antennas, treat as none
+}
+
+void gpio_init_mask(uint32_t) {}
+void gpio_set_dir_out_masked(uint32_t) {}
+void gpio_clr_mask(uint32_t mask)
+{
+  gateLines &= ~mask;
+  updateGateLines();
+}
+void gpio_set_mask(uint32_t mask)
+{
+  gateLines |= mask;
+  updateGateLines();
+}
+void gpio_put_masked(uint32_t mask, uint32_t value)
+{
+  gateLines = (gateLines & ~mask) | (value & mask);
+  updateGateLines();
+}
+
+unsigned long micros()
+{
+  nowUs += callUs;
+  return (unsigned long)nowUs;
+}
+
+unsigned long millis()
+{
+  nowUs += callUs;
+  return (unsigned long)(nowUs / 1000);
+}
+
+void delay(unsigned long ms)
+{
+  nowUs += ms * 1000.0;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  nowUs += us;
+}
+
+void yield()
+{
+  nowUs += 1;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+
+int digitalRead(uint8_t pin)
+{
+  return pinLevel[pin & 63];
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (pin == RST_PIN)
+  {
+    bool held = value == LOW;
+    if (resetHeld && !held)
+    {
+      // Leaving power down is a hard reset
+      for (Chip &c : gateChips)
+      {
+        c.reset();
+        c.readyAt = nowUs + oscillatorUs;
+      }
+      sharedChip.reset();
+      sharedChip.readyAt = nowUs + oscillatorUs;
+      for (Tag &t : tags)
+        t.state = Tag::IDLE;
+    }
+    resetHeld = held;
+  }
+  if (pin == CS_PIN_2)
+  {
+    bool low = value == LOW;
+    if (low && !csLow)
+      frameBytes = 0;
+    if (!low && csLow && frameBytes > 0)
+      counters.transactions++;
+    csLow = low;
+  }
+  pinLevel[pin & 63] = value;
+}
+
+void SPIClass::beginTransaction(SPISettings settings)
+{
+  transactionClock = settings.clock;
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+  double clock = options.spiClock > 0 ? options.spiClock : transactionClock;
+  double us = 8e6 / clock;
+  nowUs += us;
+  counters.bytes++;
+  counters.busUs += us;
+  if (!csLow)
+    return 0xFF;
+
+  Chip *chip = activeChip();
+  bool live = chip && chip->answers() && !resetHeld;
+  bool first = frameBytes++ == 0;
+  byte miso = 0x00;
+
+  if (first)
+  {
+    frameRead = data & 0x80;
+    frameAddress = (data >> 1) & 0x3F;
+  }
+  else if (frameRead)
+  {
+    if (live)
+      miso = chip->read(frameAddress);
+    if (options.trace)
+      printf("  %10.1f us  R %-15s -> 0x%02X\n", nowUs, registerNames[frameAddress], miso);
+    frameAddress = (data >> 1) & 0x3F;
+  }
+  else
+  {
+    if (live)
+      chip->write(frameAddress, data);
+    if (options.trace)
+      printf("  %10.1f us  W %-15s <- 0x%02X\n", nowUs, registerNames[frameAddress], data);
+  }
+  return miso;
+}
+
+void SPIClass::transfer(void *buffer, size_t count)
+{
+  byte *bytes = (byte *)buffer;
+  for (size_t i = 0; i < count; i++)
+    bytes[i] = transfer(bytes[i]);
+}
+
+// Setup and reports
+
+bool parseTag(const char *spec, Tag &tag)
+{
+  int gate = 0;
+  char uid[64] = {};
+  int category = 0;
+  int fields = sscanf(spec, "%d:%63[0-9A-Fa-f]:%d", &gate, uid, &category);
+  int digits = strlen(uid);
+  if (fields < 2 || gate < 1 || gate > numGatePins || (digits != 8 && digits != 14 && digits != 20))
+    return false;
+
+  tag.gate = gate - 1;
+  tag.uidSize = digits / 2;
+  for (int i = 0; i < tag.uidSize; i++)
+  {
+    char pair[3] = {uid[2 * i], uid[2 * i + 1], 0};
+    tag.uid[i] = strtoul(pair, nullptr, 16);
+  }
+  tag.category = category;
+  return true;
+}
+
+void defaultTags()
+{
+  const char *specs[] = {
+      "1:044B515AC12A81",           // Registered, looked up
+      "2:04A1B2C3D4E5F6:5",         // Category page
+      "3:1A2B3C4D:8",               // 4 byte UID
+      "4:04112233445566778899:11",  // 10 byte UID
+      "6:04DEADBEEF0102"};          // Unknown, no category
+  for (const char *spec : specs)
+  {
+    Tag tag;
+    parseTag(spec, tag);
+    tags.push_back(tag);
+  }
+}
+
+// Category checkReader() should find on a gate
+byte expectedCategory(int gate)
+{
+  for (const Tag &t : tags)
+  {
+    if (t.gate != gate)
+      continue;
+    if (t.category != 0 && TAG_CATEGORIES)
+      return t.category;
+    byte scanned[7] = {};
+    memcpy(scanned, t.uid, t.uidSize < 7 ? t.uidSize : 7);
+    return lookupCategory(scanned);
+  }
+  return 0;
+}
+
+struct GateStats
+{
+  unsigned long reads = 0;
+  unsigned long wrong = 0;
+  Counters bus;
+  double readUs = 0;
+  double maxReadUs = 0;
+};
+
+// Read every gate like readGate() in main.cpp, passes times
+int runMode(const char *name, bool fast)
+{
+  FAST_READER = fast;
+  GateStats stats[numGatePins];
+  GateStats total;
+  unsigned long fallbacks = fastFallbacks;
+
+  for (int pass = 0; pass < options.passes; pass++)
+  {
+    for (int gate = 0; gate < numGatePins; gate++)
+    {
+      openGate(tableGate(gate));
+      settleGate(tableGate(gate));
+
+      if (options.trace)
+        printf("%s, gate %d:\n", name, gate + 1);
+      Counters before = counters;
+      double start = nowUs;
+      checkReader(gate);
+      double readUs = nowUs - start;
+      closeGates();
+
+      GateStats &s = stats[gate];
+      s.reads++;
+      s.bus.transactions += counters.transactions - before.transactions;
+      s.bus.bytes += counters.bytes - before.bytes;
+      s.bus.busUs += counters.busUs - before.busUs;
+      s.readUs += readUs;
+      if (readUs > s.maxReadUs)
+        s.maxReadUs = readUs;
+      if (presentCards[gate] != expectedCategory(gate))
+        s.wrong++;
+    }
+  }
+
+  printf("%s path, SPI clock %s\n", name, options.spiClock > 0 ? "fixed" : "per transaction");
+  printf("gate  tag                    category  transactions   bytes   bus ms  read ms  max ms  wrong\n");
+  for (int gate = 0; gate < numGatePins; gate++)
+  {
+    const GateStats &s = stats[gate];
+    char uid[32] = "-";
+    for (const Tag &t : tags)
+    {
+      if (t.gate != gate)
+        continue;
+      for (int i = 0; i < t.uidSize; i++)
+        sprintf(uid + 2 * i, "%02X", t.uid[i]);
+    }
+    printf("%4d  %-21s  %8d  %12.1f  %6.1f  %7.3f  %7.2f  %6.2f  %5lu\n", gate + 1, uid, expectedCategory(gate),
+           (double)s.bus.transactions / s.reads, (double)s.bus.bytes / s.reads, s.bus.busUs / s.reads / 1000,
+           s.readUs / s.reads / 1000, s.maxReadUs / 1000, s.wrong);
+
+    total.reads += s.reads;
+    total.wrong += s.wrong;
+    total.bus.transactions += s.bus.transactions;
+    total.bus.bytes += s.bus.bytes;
+    total.bus.busUs += s.bus.busUs;
+    total.readUs += s.readUs;
+  }
+  printf("scan  %lu reads, %.1f transactions, %.1f bytes, bus %.3f ms, reads %.2f ms per scan",
+         total.reads, (double)total.bus.transactions / options.passes, (double)total.bus.bytes / options.passes,
+         total.bus.busUs / options.passes / 1000, total.readUs / options.passes / 1000);
+  if (fast)
+    printf(", %lu library fallbacks", fastFallbacks - fallbacks);
+  printf(", %lu wrong\n\n", total.wrong);
+  return total.wrong > 0;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned seed = 1;
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    bool more = i + 1 < argc;
+    if (strcmp(arg, "--spi-clock") == 0 && more)
+      options.spiClock = atof(argv[++i]);
+    else if (strcmp(arg, "--passes") == 0 && more)
+      options.passes = atoi(argv[++i]);
+    else if (strcmp(arg, "--mode") == 0 && more)
+    {
+      const char *mode = argv[++i];
+      options.fast = strcmp(mode, "library") != 0;
+      options.library = strcmp(mode, "fast") != 0;
+    }
+    else if (strcmp(arg, "--shared-reader") == 0)
+      options.sharedReader = true;
+    else if (strcmp(arg, "--settle") == 0 && more)
+      options.settleUs = atof(argv[++i]);
+    else if (strcmp(arg, "--drop") == 0 && more)
+      options.dropRate = atof(argv[++i]);
+    else if (strcmp(arg, "--seed") == 0 && more)
+      seed = atoi(argv[++i]);
+    else if (strcmp(arg, "--trace") == 0)
+      options.trace = true;
+    else if (strcmp(arg, "--debug") == 0)
+      DEBUG = Serial.enabled = true;
+    else if (strcmp(arg, "--tag") == 0 && more)
+    {
+      Tag tag;
+      if (!parseTag(argv[++i], tag))
+      {
+        fprintf(stderr, "bad tag %s, expected gate:uid[:category]\n", argv[i]);
+        return 2;
+      }
+      tags.push_back(tag);
+    }
+    else
+    {
+      fprintf(stderr,
+              "usage: %s [--spi-clock hz] [--passes n] [--mode fast|library|both] [--shared-reader]\n"
+              "       [--settle us] [--drop p] [--seed n] [--trace] [--debug] [--tag gate:uid[:category]] ...\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (options.passes < 1)
+    options.passes = 1;
+  srand(seed);
+
+  if (tags.empty())
+    defaultTags();
+  for (Tag &t : tags)
+    t.setup();
+
+  sharedChip.reset();
+  sharedChip.powered = true;
+  pinLevel[CS_PIN_2] = HIGH;
+  pinLevel[RST_PIN] = HIGH;
+
+  // Boot steps that touch the reader, as in setup() and bootStep()
+  initGates();
+  SPI.begin();
+  initializeReader();
+  calibrateGates(rfid);
+  printf("Boot: %.1f ms, %lu transactions, %lu bytes\n", nowUs / 1000, counters.transactions, counters.bytes);
+  printf("Gate settle:");
+  for (int i = 0; i < numGatePins; i++)
+    printf(" %lu", gateSettleUs[i]);
+  printf(" us, break %lu us\n\n", gateBreakUs);
+
+  int failed = 0;
+  if (options.fast)
+    failed |= runMode("fast", true);
+  if (options.library)
+    failed |= runMode("library", false);
+  return failed;
+}
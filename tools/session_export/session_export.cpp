@@ -0,0 +1,215 @@
+// Decoder for the session log sent by the EXPORT console command
+// (src/analytics.h).
+//
+// Capture the serial port while typing EXPORT, for example
+//   cat /dev/ttyACM0 > export.bin   (and EXPORT in another terminal)
+// then summarise it: presses and branches per level, and how long tables
+// spend in each level, from the press that completes the previous level (or
+// the first press after a boot) to the press that completes the level.
+//
+// Build and run on the host from the repository root:
+//   g++ -O2 -std=c++17 -I src tools/session_export/session_export.cpp -o session_export
+//   ./session_export export.bin [--csv records.csv]
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+typedef uint8_t byte;
+#include "rules.h"
+#include "telemetry.h"
+
+// Same layout as SessionRecord in src/analytics.h
+struct Record
+{
+  uint32_t sequence;
+  uint32_t timeMs;
+  uint16_t boot;
+  byte table;
+  byte level;
+  byte branch;
+  byte track;
+  byte nextLevel;
+  byte reserved;
+  uint64_t board;
+  byte cards[numGatePins];
+  uint16_t check;
+};
+
+static_assert(sizeof(Record) == 32, "Record layout differs from the device");
+
+static const char *branchNames[BRANCH_COUNT] = {"mask", "illegal", "rule0", "rule1", "rule2", "rule3", "fallback", "invalid"};
+const int maxLevel = 11; // Levels 0 to 5 and 10
+
+struct LevelStats
+{
+  unsigned long presses = 0;
+  unsigned long branches[BRANCH_COUNT] = {};
+  std::vector<double> dwellS;
+};
+
+static bool readFile(const char *path, std::vector<byte> &data)
+{
+  FILE *f = fopen(path, "rb");
+  if (!f)
+  {
+    perror(path);
+    return false;
+  }
+  byte chunk[65536];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    data.insert(data.end(), chunk, chunk + n);
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  const char *input = nullptr;
+  const char *csvPath = nullptr;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+      csvPath = argv[++i];
+    else
+      input = argv[i];
+  }
+
+  if (!input)
+  {
+    fprintf(stderr, "usage: %s export.bin [--csv records.csv]\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<byte> data;
+  if (!readFile(input, data))
+    return 1;
+
+  // The block can be surrounded by console text and telemetry frames
+  const byte magic[4] = {'N', 'V', 'S', 'L'};
+  auto start = std::search(data.begin(), data.end(), magic, magic + 4);
+  if (start == data.end())
+  {
+    fprintf(stderr, "%s: no session export found\n", input);
+    return 1;
+  }
+  size_t pos = start - data.begin() + 4;
+
+  if (data.size() - pos < 6)
+  {
+    fprintf(stderr, "%s: export is cut short\n", input);
+    return 1;
+  }
+  uint16_t recordSize = data[pos] | data[pos + 1] << 8;
+  uint32_t count;
+  memcpy(&count, &data[pos + 2], 4);
+  if (recordSize != sizeof(Record))
+  {
+    fprintf(stderr, "%s: records of %u bytes, expected %zu\n", input, recordSize, sizeof(Record));
+    return 1;
+  }
+  if (data.size() - pos - 6 < (size_t)count * sizeof(Record) + 2)
+  {
+    fprintf(stderr, "%s: export of %u records is cut short\n", input, count);
+    return 1;
+  }
+
+  uint16_t crc = 0xFFFF;
+  for (size_t i = pos + 2; i < pos + 6 + (size_t)count * sizeof(Record); i++)
+    crc = crc16(crc, data[i]);
+  size_t crcAt = pos + 6 + (size_t)count * sizeof(Record);
+  if ((data[crcAt] | data[crcAt + 1] << 8) != crc)
+  {
+    fprintf(stderr, "%s: CRC mismatch, the export is damaged\n", input);
+    return 1;
+  }
+
+  std::vector<Record> records(count);
+  memcpy(records.data(), &data[pos + 6], (size_t)count * sizeof(Record));
+
+  FILE *csv = nullptr;
+  if (csvPath)
+  {
+    csv = fopen(csvPath, "w");
+    if (!csv)
+    {
+      perror(csvPath);
+      return 1;
+    }
+    fprintf(csv, "sequence,boot,time_ms,table,level,branch,track,next_level");
+    for (int i = 0; i < numGatePins; i++)
+      fprintf(csv, ",gate%d", i + 1);
+    fprintf(csv, "\n");
+  }
+
+  LevelStats levels[maxLevel];
+  std::vector<long> levelStart(256, -1); // Per boot and table: ms the level was entered
+  int lastBoot = -1;
+
+  for (const Record &r : records)
+  {
+    if (csv)
+    {
+      fprintf(csv, "%u,%u,%u,%u,%u,%s,%u,%u", r.sequence, r.boot, r.timeMs, r.table + 1, r.level,
+              r.branch < BRANCH_COUNT ? branchNames[r.branch] : "?", r.track, r.nextLevel);
+      for (int i = 0; i < numGatePins; i++)
+        fprintf(csv, ",%u", r.cards[i]);
+      fprintf(csv, "\n");
+    }
+
+    if (r.boot != lastBoot)
+    {
+      std::fill(levelStart.begin(), levelStart.end(), -1);
+      lastBoot = r.boot;
+    }
+    if (r.level >= maxLevel || r.branch >= BRANCH_COUNT)
+      continue;
+
+    LevelStats &ls = levels[r.level];
+    ls.presses++;
+    ls.branches[r.branch]++;
+
+    long &entered = levelStart[r.table];
+    if (entered < 0)
+      entered = r.timeMs;
+    if (r.nextLevel != r.level)
+    {
+      if (r.branch == BRANCH_RULE_0)
+        ls.dwellS.push_back((r.timeMs - entered) / 1000.0);
+      entered = r.timeMs;
+    }
+  }
+  if (csv)
+    fclose(csv);
+
+  printf("%u records\n", count);
+  printf("level  presses  completed  median s  mean s   branches\n");
+  for (int l = 0; l < maxLevel; l++)
+  {
+    LevelStats &ls = levels[l];
+    if (ls.presses == 0)
+      continue;
+
+    double median = 0, mean = 0;
+    if (!ls.dwellS.empty())
+    {
+      std::sort(ls.dwellS.begin(), ls.dwellS.end());
+      median = ls.dwellS[ls.dwellS.size() / 2];
+      for (double d : ls.dwellS)
+        mean += d;
+      mean /= ls.dwellS.size();
+    }
+    printf("%5d  %7lu  %9zu  %8.1f  %6.1f  ", l, ls.presses, ls.dwellS.size(), median, mean);
+    for (int b = 0; b < BRANCH_COUNT; b++)
+    {
+      if (ls.branches[b] > 0)
+        printf(" %s %lu", branchNames[b], ls.branches[b]);
+    }
+    printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,417 @@
+// Aggregator for the binary telemetry of src/telemetry.h.
+//
+// Reads the USB serial ports of several installations at once, or capture
+// files recorded from them (cat /dev/ttyACM0 > table1.bin), and keeps live
+// metrics per installation: scans, verdicts per branch, level transitions,
+// stage timings and the device error counters, plus the health of the link
+// itself (CRC errors, lost frames, non-telemetry bytes such as DEBUG text).
+//
+// Build and run on the host from the repository root:
+//   g++ -O2 -std=c++17 -I src tools/telemetry_agg/telemetry_agg.cpp -o telemetry_agg
+//   ./telemetry_agg [--interval s] /dev/ttyACM0 /dev/ttyACM1 capture.bin ...
+//
+// Telemetry is off by default on the controller; the tool sends
+// "TELEMETRY on" to every serial port it opens. A summary is printed every
+// interval while serial ports are open. When all sources are files the tool
+// exits after printing the summary at their end.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+typedef uint8_t byte;
+#include "rules.h"
+#include "telemetry.h"
+
+const int maxTables = 8;
+
+static const char *branchNames[BRANCH_COUNT] = {"mask", "illegal", "rule0", "rule1", "rule2", "rule3", "fallback", "invalid"};
+static const char *stageNames[STAGE_COUNT] = {"scan", "confirm", "evaluate", "latency"};
+
+struct StageStats
+{
+  unsigned long count = 0;
+  double sumUs = 0;
+  uint32_t maxUs = 0;
+};
+
+struct TableStats
+{
+  unsigned long scans = 0;
+  unsigned long recoveredGates = 0;
+  unsigned long busScans = 0; // Scans that report their bus traffic
+  double busTransactions = 0;
+  double busBytes = 0;
+  unsigned long libraryGates = 0;
+  unsigned long verdicts[BRANCH_COUNT] = {};
+  unsigned long levelChanges = 0;
+  unsigned long hints = 0;
+  unsigned long hintDistance[4] = {}; // 1, 2, 3, more edits away
+  int level = -1;
+  int lastCards[numGatePins] = {};
+  StageStats stages[STAGE_COUNT];
+};
+
+struct Source
+{
+  std::string name;
+  int fd = -1;
+  bool file = false;
+  bool done = false;
+  std::vector<byte> buffer;
+
+  // Link health
+  unsigned long bytes = 0;
+  unsigned long frames = 0;
+  unsigned long crcErrors = 0;
+  unsigned long lostFrames = 0;
+  unsigned long skippedBytes = 0; // Text and garbage between frames
+  int lastSequence = -1;
+
+  // Device
+  unsigned long boots = 0;
+  uint32_t bootReadyMs = 0;
+  unsigned watchdogResets = 0;
+  int tables = 0;
+  bool haveCounters = false;
+  uint32_t uptime = 0;
+  unsigned audioTimeouts = 0, audioErrors = 0, recoveredGates = 0, budgetMisses = 0, droppedFrames = 0;
+  TableStats table[maxTables];
+};
+
+static uint16_t get16(const byte *p)
+{
+  return p[0] | p[1] << 8;
+}
+
+static uint32_t get32(const byte *p)
+{
+  return get16(p) | (uint32_t)get16(p + 2) << 16;
+}
+
+static void handleFrame(Source &src, byte type, const byte *p, int length)
+{
+  int t = length > 0 && p[0] < maxTables ? p[0] : 0;
+  TableStats &ts = src.table[t];
+
+  switch (type)
+  {
+  case EV_BOOT:
+    if (length < 7)
+      break;
+    src.boots++;
+    src.bootReadyMs = get32(p);
+    src.watchdogResets = get16(p + 4);
+    src.tables = p[6];
+    break;
+
+  case EV_SCAN:
+    if (length < 6)
+      break;
+    ts.scans++;
+    ts.level = p[1];
+    if (length >= 14)
+    {
+      // A byte per gate
+      for (int i = 0; i < numGatePins; i++)
+        ts.lastCards[i] = p[2 + i];
+      p += 3; // Line the rest up with the older layout
+    }
+    else
+    {
+      for (int i = 0; i < numGatePins; i++)
+        ts.lastCards[i] = (p[2 + i / 2] >> (4 * (i & 1))) & 0x0F;
+    }
+    ts.recoveredGates += __builtin_popcount(p[5]);
+    if (length >= 11)
+    {
+      ts.busScans++;
+      ts.busTransactions += get16(p + 6);
+      ts.busBytes += get16(p + 8);
+      ts.libraryGates += __builtin_popcount(p[10]);
+    }
+    break;
+
+  case EV_TIMING:
+    if (length < 6 || p[1] >= STAGE_COUNT)
+      break;
+    {
+      StageStats &st = ts.stages[p[1]];
+      uint32_t us = get32(p + 2);
+      st.count++;
+      st.sumUs += us;
+      if (us > st.maxUs)
+        st.maxUs = us;
+    }
+    break;
+
+  case EV_LEVEL:
+    if (length < 3)
+      break;
+    ts.levelChanges++;
+    ts.level = p[2];
+    break;
+
+  case EV_VERDICT:
+    if (length < 4 || p[2] >= BRANCH_COUNT)
+      break;
+    ts.verdicts[p[2]]++;
+    break;
+
+  case EV_HINT:
+    if (length < 6 || p[2] == 0)
+      break;
+    ts.hints++;
+    ts.hintDistance[p[2] < 4 ? p[2] - 1 : 3]++;
+    break;
+
+  case EV_COUNTERS:
+    if (length < 14)
+      break;
+    src.haveCounters = true;
+    src.uptime = get32(p);
+    src.audioTimeouts = get16(p + 4);
+    src.audioErrors = get16(p + 6);
+    src.recoveredGates = get16(p + 8);
+    src.budgetMisses = get16(p + 10);
+    src.droppedFrames = get16(p + 12);
+    break;
+  }
+}
+
+// Take every complete frame out of the buffer, skipping bytes that are not
+// part of a valid frame
+static void parseFrames(Source &src)
+{
+  std::vector<byte> &buf = src.buffer;
+  size_t pos = 0;
+
+  while (true)
+  {
+    size_t sync = pos;
+    while (sync < buf.size() && buf[sync] != telemetrySync)
+      sync++;
+    src.skippedBytes += sync - pos;
+    pos = sync;
+
+    if (buf.size() - pos < (size_t)telemetryHeader)
+      break;
+
+    int length = buf[pos + 3];
+    if (length > telemetryMaxPayload)
+    {
+      src.skippedBytes++;
+      pos++;
+      continue;
+    }
+
+    size_t frameSize = telemetryHeader + length + telemetryTrailer;
+    if (buf.size() - pos < frameSize)
+      break;
+
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 1; i < telemetryHeader + (size_t)length; i++)
+      crc = crc16(crc, buf[pos + i]);
+    if (get16(&buf[pos + telemetryHeader + length]) != crc)
+    {
+      // Resynchronise on the next sync byte
+      src.crcErrors++;
+      src.skippedBytes++;
+      pos++;
+      continue;
+    }
+
+    byte sequence = buf[pos + 1];
+    if (src.lastSequence >= 0)
+      src.lostFrames += (byte)(sequence - src.lastSequence - 1);
+    src.lastSequence = sequence;
+    src.frames++;
+
+    handleFrame(src, buf[pos + 2], &buf[pos + telemetryHeader], length);
+    pos += frameSize;
+  }
+
+  buf.erase(buf.begin(), buf.begin() + pos);
+}
+
+static bool openSource(Source &src)
+{
+  src.fd = open(src.name.c_str(), O_RDWR | O_NOCTTY);
+  if (src.fd < 0)
+    src.fd = open(src.name.c_str(), O_RDONLY | O_NOCTTY); // Read-only capture
+  if (src.fd < 0)
+  {
+    fprintf(stderr, "%s: %s\n", src.name.c_str(), strerror(errno));
+    return false;
+  }
+
+  if (isatty(src.fd))
+  {
+    // USB CDC ignores the rate, but the line must be raw
+    struct termios tio;
+    tcgetattr(src.fd, &tio);
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, B9600);
+    tcsetattr(src.fd, TCSANOW, &tio);
+
+    const char enable[] = "TELEMETRY on\n";
+    if (write(src.fd, enable, sizeof(enable) - 1) < 0)
+      fprintf(stderr, "%s: cannot switch telemetry on: %s\n", src.name.c_str(), strerror(errno));
+  }
+  else
+  {
+    src.file = true;
+  }
+  return true;
+}
+
+static void printStage(const StageStats &st, const char *name)
+{
+  if (st.count == 0)
+    return;
+  printf("      %-8s n=%-6lu avg %9.1f ms  max %9.1f ms\n", name, st.count,
+         st.sumUs / st.count / 1000.0, st.maxUs / 1000.0);
+}
+
+static void printSummary(const std::vector<Source> &sources)
+{
+  for (const Source &src : sources)
+  {
+    printf("%s%s\n", src.name.c_str(), src.done ? " (ended)" : "");
+    printf("  link: %lu bytes, %lu frames, %lu CRC errors, %lu lost, %lu other bytes\n",
+           src.bytes, src.frames, src.crcErrors, src.lostFrames, src.skippedBytes);
+    if (src.boots > 0)
+      printf("  boot: %lu boots, ready after %u ms, %u watchdog resets, %d tables\n",
+             src.boots, (unsigned)src.bootReadyMs, src.watchdogResets, src.tables);
+    if (src.haveCounters)
+      printf("  counters: uptime %u s, audio timeouts %u, audio errors %u, recovered gates %u, "
+             "budget misses %u, dropped frames %u\n",
+             (unsigned)src.uptime, src.audioTimeouts, src.audioErrors, src.recoveredGates,
+             src.budgetMisses, src.droppedFrames);
+
+    for (int t = 0; t < maxTables; t++)
+    {
+      const TableStats &ts = src.table[t];
+      if (ts.scans == 0 && ts.levelChanges == 0)
+        continue;
+
+      printf("    table %d: level %d, %lu level changes, %lu scans, %lu recovered gates, board",
+             t + 1, ts.level, ts.levelChanges, ts.scans, ts.recoveredGates);
+      for (int i = 0; i < numGatePins; i++)
+        printf(" %d", ts.lastCards[i]);
+      printf("\n      verdicts:");
+      for (int b = 0; b < BRANCH_COUNT; b++)
+      {
+        if (ts.verdicts[b] > 0)
+          printf(" %s %lu", branchNames[b], ts.verdicts[b]);
+      }
+      printf("\n");
+      if (ts.busScans > 0)
+        printf("      reader bus: %.1f transactions, %.1f bytes per scan, %lu gates read by the library\n",
+               ts.busTransactions / ts.busScans, ts.busBytes / ts.busScans, ts.libraryGates);
+      if (ts.hints > 0)
+        printf("      hints: %lu, 1 edit away %lu, 2 edits %lu, 3 edits %lu, more %lu\n", ts.hints,
+               ts.hintDistance[0], ts.hintDistance[1], ts.hintDistance[2], ts.hintDistance[3]);
+      for (int s = 0; s < STAGE_COUNT; s++)
+        printStage(ts.stages[s], stageNames[s]);
+    }
+  }
+  printf("\n");
+  fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+  std::vector<Source> sources;
+  double interval = 1.0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc)
+    {
+      interval = atof(argv[++i]);
+      continue;
+    }
+    Source src;
+    src.name = argv[i];
+    sources.push_back(src);
+  }
+
+  if (sources.empty())
+  {
+    fprintf(stderr, "usage: %s [--interval s] device-or-capture ...\n", argv[0]);
+    return 2;
+  }
+
+  for (Source &src : sources)
+  {
+    if (!openSource(src))
+      return 1;
+  }
+
+  struct timespec last;
+  clock_gettime(CLOCK_MONOTONIC, &last);
+  byte chunk[4096];
+
+  while (true)
+  {
+    std::vector<struct pollfd> fds;
+    std::vector<Source *> open;
+    for (Source &src : sources)
+    {
+      if (!src.done)
+      {
+        fds.push_back({src.fd, POLLIN, 0});
+        open.push_back(&src);
+      }
+    }
+    if (fds.empty())
+      break;
+
+    poll(fds.data(), fds.size(), 100);
+
+    for (size_t i = 0; i < fds.size(); i++)
+    {
+      if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+        continue;
+
+      Source &src = *open[i];
+      ssize_t n = read(src.fd, chunk, sizeof(chunk));
+      if (n <= 0)
+      {
+        if (n < 0 && (errno == EINTR || errno == EAGAIN))
+          continue;
+        src.done = true;
+        close(src.fd);
+        continue;
+      }
+      src.bytes += n;
+      src.buffer.insert(src.buffer.end(), chunk, chunk + n);
+      parseFrames(src);
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (now.tv_sec - last.tv_sec) + (now.tv_nsec - last.tv_nsec) / 1e9;
+    bool live = false;
+    for (const Source &src : sources)
+      live |= !src.file && !src.done;
+    if (live && elapsed >= interval)
+    {
+      printSummary(sources);
+      last = now;
+    }
+  }
+
+  printSummary(sources);
+  return 0;
+}
@@ -0,0 +1,458 @@
+// Exhaustive verifier and throughput benchmark for the rule set in src/rules.h.
+//
+// Every board (six gates, each empty or holding one of the 13 categories) is
+// evaluated at every level. The report lists per level which track each
+// branch plays, how often every rule fires, rules that never decide an
+// outcome (shadowed by an earlier rule) and states where more than one rule
+// matches, so the order of the chain decides the outcome. It also checks
+// that every rule only depends on the inputs it declares in levelRules.
+// The hint engine in src/hints.h is checked against a breadth-first search
+// from the winning boards of each level: on sampled boards its distance must
+// be exact and its first edit must bring the board one edit closer.
+//
+// Build and run on the host from the repository root:
+//   g++ -O2 -std=c++17 -I src tools/verify_rules/verify_rules.cpp -o verify_rules
+//   ./verify_rules [--dump states.csv]
+//
+// The exit code is non-zero when a rule can never decide an outcome, reads
+// inputs it does not declare or a hint is wrong.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+typedef uint8_t byte;
+
+// hints.h times its search and can print a hint
+unsigned long micros()
+{
+  return 0;
+}
+
+struct NullSerial
+{
+  template <typename T> void print(T) {}
+  template <typename T> void println(T) {}
+} Serial;
+
+#include "hints.h"
+
+const int numValues = 14; // Empty gate plus 13 categories
+
+static long boardCount()
+{
+  long count = 1;
+  for (int i = 0; i < numGatePins; i++)
+  {
+    count *= numValues;
+  }
+  return count;
+}
+
+static void loadBoard(long index)
+{
+  for (int i = 0; i < numGatePins; i++)
+  {
+    presentCards[i] = index % numValues;
+    index /= numValues;
+  }
+  countCards();
+}
+
+struct LevelStats
+{
+  long branchCount[BRANCH_COUNT];
+  long ruleMatched[maxRulesPerLevel]; // Predicate true when the chain is reached
+  long ruleDecided[maxRulesPerLevel]; // Predicate decided the outcome
+  long overlap[maxRulesPerLevel][maxRulesPerLevel];
+  long trackCount[256];
+  long ambiguous; // States where more than one rule matches
+};
+
+static LevelStats stats[numLevels];
+
+// Result of each rule per combination of its declared group totals, -1 unseen
+static std::vector<signed char> declaredResults[numLevels][maxRulesPerLevel];
+static long undeclaredInputs[numLevels][maxRulesPerLevel];
+
+static int declaredKey(uint16_t reads)
+{
+  int key = 0;
+  for (int g = 0; g < GROUP_COUNT; g++)
+  {
+    if (reads & (1 << g))
+      key = key * (numGatePins + 1) + groupTotal(g);
+  }
+  return key;
+}
+
+// A rule that gives two results for the same declared inputs reads more
+// than it declares, so the incremental evaluator could reuse a stale result
+static void checkDeclaredInputs(int level)
+{
+  const LevelRules &lr = levelRules[level];
+  for (int i = 0; i < maxRulesPerLevel; i++)
+  {
+    if (lr.rules[i] == nullptr)
+      continue;
+
+    std::vector<signed char> &results = declaredResults[level][i];
+    if (results.empty())
+      results.assign(823543, -1); // 7^7, every group total from 0 to 6
+
+    if (lr.reads[i] & IN_CARDS)
+      continue; // Depends on the whole board
+
+    signed char result = lr.rules[i]() ? 1 : 0;
+    signed char &seen = results[declaredKey(lr.reads[i])];
+    if (seen == -1)
+      seen = result;
+    else if (seen != result)
+      undeclaredInputs[level][i]++;
+  }
+}
+
+static const char *branchName(int branch)
+{
+  switch (branch)
+  {
+  case BRANCH_MASK:
+    return "mask";
+  case BRANCH_ILLEGAL:
+    return "illegal";
+  case BRANCH_RULE_0:
+    return "rule 0";
+  case BRANCH_RULE_1:
+    return "rule 1";
+  case BRANCH_RULE_2:
+    return "rule 2";
+  case BRANCH_RULE_3:
+    return "rule 3";
+  case BRANCH_FALLBACK:
+    return "fallback";
+  default:
+    return "invalid level";
+  }
+}
+
+static int verify(FILE *dump)
+{
+  long boards = boardCount();
+  int errors = 0;
+
+  if (dump)
+  {
+    fprintf(dump, "level,g1,g2,g3,g4,g5,g6,branch,track,next\n");
+  }
+
+  for (long b = 0; b < boards; b++)
+  {
+    loadBoard(b);
+    bool masked = matchConnectionMasks();
+
+    for (int level = 0; level < numLevels; level++)
+    {
+      LevelStats &ls = stats[level];
+      Outcome outcome = evaluateBoard(level);
+
+      ls.branchCount[outcome.branch]++;
+      ls.trackCount[outcome.track]++;
+
+      if (dump)
+      {
+        fprintf(dump, "%d", level);
+        for (int i = 0; i < numGatePins; i++)
+        {
+          fprintf(dump, ",%d", presentCards[i]);
+        }
+        fprintf(dump, ",%s,%d,%d\n", branchName(outcome.branch), outcome.track, outcome.nextLevel);
+      }
+
+      if (outcome.track == 0)
+      {
+        if (errors++ < 10)
+        {
+          printf("error: level %d board %ld has no track\n", level, b);
+        }
+      }
+
+      checkDeclaredInputs(level);
+
+      if (!masked || hasIllegalComponents(level))
+        continue;
+
+      // The rule chain is reached, record every matching predicate
+      const LevelRules &lr = levelRules[level];
+      bool matched[maxRulesPerLevel] = {false};
+      int matches = 0;
+      for (int i = 0; i < maxRulesPerLevel; i++)
+      {
+        if (lr.rules[i] != nullptr && lr.rules[i]())
+        {
+          matched[i] = true;
+          ls.ruleMatched[i]++;
+          matches++;
+        }
+      }
+
+      for (int i = 0; i < maxRulesPerLevel; i++)
+      {
+        for (int j = i + 1; j < maxRulesPerLevel; j++)
+        {
+          if (matched[i] && matched[j])
+            ls.overlap[i][j]++;
+        }
+      }
+
+      if (matches > 1)
+        ls.ambiguous++;
+
+      if (outcome.branch >= BRANCH_RULE_0 && outcome.branch <= BRANCH_RULE_3)
+      {
+        ls.ruleDecided[outcome.branch - BRANCH_RULE_0]++;
+      }
+    }
+  }
+
+  return errors;
+}
+
+static int report()
+{
+  int problems = 0;
+
+  for (int level = 0; level < numLevels; level++)
+  {
+    const LevelStats &ls = stats[level];
+    const LevelRules &lr = levelRules[level];
+
+    printf("\nLevel %d\n", level);
+    for (int branch = 0; branch < BRANCH_COUNT; branch++)
+    {
+      if (ls.branchCount[branch] == 0)
+        continue;
+      printf("  %-14s %9ld states\n", branchName(branch), ls.branchCount[branch]);
+    }
+
+    printf("  tracks:");
+    for (int track = 0; track < 256; track++)
+    {
+      if (ls.trackCount[track] > 0)
+        printf(" %03d=%ld", track, ls.trackCount[track]);
+    }
+    printf("\n");
+
+    for (int i = 0; i < maxRulesPerLevel; i++)
+    {
+      if (lr.rules[i] == nullptr)
+        continue;
+
+      long shadowed = ls.ruleMatched[i] - ls.ruleDecided[i];
+      printf("  lvl%d_%d: matches %ld, decides %ld, shadowed %ld\n",
+             level, i, ls.ruleMatched[i], ls.ruleDecided[i], shadowed);
+
+      if (ls.ruleDecided[i] == 0)
+      {
+        printf("  warning: lvl%d_%d is unreachable\n", level, i);
+        problems++;
+      }
+
+      if (undeclaredInputs[level][i] > 0)
+      {
+        printf("  error: lvl%d_%d reads inputs it does not declare (%ld states)\n",
+               level, i, undeclaredInputs[level][i]);
+        problems++;
+      }
+
+      for (int j = 0; j < i; j++)
+      {
+        if (ls.overlap[j][i] > 0)
+        {
+          printf("    shadowed by lvl%d_%d in %ld states\n", level, j, ls.overlap[j][i]);
+        }
+      }
+    }
+    printf("  ambiguous states (more than one rule matches): %ld\n", ls.ambiguous);
+  }
+
+  return problems;
+}
+
+const long hintSamples = 200000; // Boards per level compared with the search
+const byte unreachable = 0xFF;
+
+static long boardIndex()
+{
+  long index = 0;
+  for (int i = numGatePins - 1; i >= 0; i--)
+  {
+    index = index * numValues + presentCards[i];
+  }
+  return index;
+}
+
+// Edits from every board to the nearest one that completes level. An edit
+// changes one gate (add, remove or swap a tile), so the search steps to the
+// 6 * 13 boards that differ in a single gate.
+static void hintDistances(int level, std::vector<byte> &distance)
+{
+  long boards = boardCount();
+  std::vector<uint32_t> frontier, next;
+  distance.assign(boards, unreachable);
+
+  for (long b = 0; b < boards; b++)
+  {
+    loadBoard(b);
+    if (evaluateBoard(level).branch == BRANCH_RULE_0)
+    {
+      distance[b] = 0;
+      frontier.push_back(b);
+    }
+  }
+
+  for (byte d = 1; !frontier.empty(); d++)
+  {
+    next.clear();
+    for (uint32_t b : frontier)
+    {
+      long stride = 1;
+      for (int i = 0; i < numGatePins; i++, stride *= numValues)
+      {
+        long digit = (b / stride) % numValues;
+        for (long v = 0; v < numValues; v++)
+        {
+          long neighbour = b + (v - digit) * stride;
+          if (distance[neighbour] == unreachable)
+          {
+            distance[neighbour] = d;
+            next.push_back(neighbour);
+          }
+        }
+      }
+    }
+    frontier.swap(next);
+  }
+}
+
+static int checkHintDistances()
+{
+  checkDecisionTable();
+  if (!checkHints())
+  {
+    printf("\nerror: the winning histograms disagree with the rules, hints are off\n");
+    return 1;
+  }
+
+  printf("\nHints against a breadth-first search, %ld boards per level\n", hintSamples);
+  std::vector<byte> distance;
+  int problems = 0;
+  srand(1);
+
+  for (int level = 0; level < numLevels; level++)
+  {
+    hintDistances(level, distance);
+    long wrongDistance = 0;
+    long wrongEdit = 0;
+    long histogram[numGatePins + 2] = {0};
+
+    for (long s = 0; s < hintSamples; s++)
+    {
+      long b = ((long)rand() * RAND_MAX + rand()) % boardCount();
+      loadBoard(b);
+      Hint hint = findHint(level);
+      byte expected = distance[b] == unreachable ? 0 : distance[b];
+      histogram[expected <= numGatePins ? expected : numGatePins + 1]++;
+
+      if (hint.distance != expected)
+      {
+        if (wrongDistance++ < 5)
+          printf("  error: level %d board %ld hint %d edits, search %d\n", level, b, hint.distance, expected);
+        continue;
+      }
+
+      // The first edit has to lead one step closer
+      if (hint.action == HINT_REMOVE)
+        presentCards[hint.gate] = 0;
+      else if (hint.action == HINT_ADD || hint.action == HINT_SWAP)
+        presentCards[hint.gate] = hint.group < GROUP_COUNT ? groupCategory[hint.group] : 0;
+      bool closer = hint.action == HINT_NONE ? expected == 0 : distance[boardIndex()] == expected - 1;
+      if (!closer && wrongEdit++ < 5)
+        printf("  error: level %d board %ld first edit does not lead closer\n", level, b);
+    }
+
+    printf("  level %d: distances", level);
+    for (int d = 0; d <= numGatePins; d++)
+    {
+      printf(" %d=%ld", d, histogram[d]);
+    }
+    printf(", wrong distances %ld, wrong first edits %ld\n", wrongDistance, wrongEdit);
+    if (wrongDistance > 0 || wrongEdit > 0)
+      problems++;
+  }
+  return problems;
+}
+
+static void benchmark()
+{
+  long boards = boardCount();
+  volatile int sink = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (long b = 0; b < boards; b++)
+  {
+    loadBoard(b);
+    for (int level = 0; level < numLevels; level++)
+    {
+      sink += evaluateBoard(level).track;
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  double evaluations = (double)boards * numLevels;
+  printf("\nBenchmark: %.0f evaluations in %.3f s, %.1f M evaluations/s\n",
+         evaluations, seconds, evaluations / seconds / 1e6);
+}
+
+int main(int argc, char **argv)
+{
+  FILE *dump = nullptr;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc)
+    {
+      dump = fopen(argv[++i], "w");
+      if (!dump)
+      {
+        perror(argv[i]);
+        return 2;
+      }
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [--dump states.csv]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  printf("Verifying %ld boards at %d levels\n", boardCount(), numLevels);
+  int errors = verify(dump);
+  if (dump)
+  {
+    fclose(dump);
+  }
+
+  int problems = report();
+  problems += checkHintDistances();
+  benchmark();
+
+  if (errors > 0)
+  {
+    printf("\n%d states without a track\n", errors);
+  }
+  return (errors > 0 || problems > 0) ? 1 : 0;
+}